@@ -27,6 +27,20 @@ namespace gl {
     glDrawElements(static_cast <u32> (m_draw_mode), ib.get_count(), GL_UNSIGNED_INT, static_cast <const void*> (0));
   }
 
+  // Draws `count` u32 indices starting at byte `offset` of a streamed index
+  // buffer, each added to `base_vertex`
+  void renderer::draw_elements (const vertex_array &va, const stream_buffer &ib, const shader_program &s, u32 offset, u32 count, i32 base_vertex) const {
+    s.bind();
+    va.bind();
+    ib.bind();
+
+    glDrawElementsBaseVertex(
+      static_cast <u32> (m_draw_mode), count, GL_UNSIGNED_INT,
+      reinterpret_cast <const void*> (static_cast <std::uintptr_t> (offset)),
+      base_vertex
+    );
+  }
+
   const glm::vec4& renderer::get_clear_color () const {
     return m_clear_color;
   }
@@ -5,6 +5,7 @@
 
 #include "vertex/vertex_array.hpp"
 #include "vertex/index_buffer.hpp"
+#include "vertex/stream_buffer.hpp"
 #include "shader/shader.hpp"
 
 namespace gl {
@@ -36,6 +37,7 @@ namespace gl {
 
       void clear () const;
       void draw_elements (const vertex_array&, const index_buffer&, const shader_program&) const;
+      void draw_elements (const vertex_array&, const stream_buffer&, const shader_program&, u32, u32, i32) const;
 
       const glm::vec4& get_clear_color () const;
       const draw_mode& get_draw_mode () const;
@@ -0,0 +1,150 @@
+#include <iostream>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "stream_buffer.hpp"
+
+namespace gl {
+
+  // How long one wait for a segment's fence lasts before trying again, in
+  // nanoseconds
+  static constexpr u64 fence_timeout = 1000000;
+
+  stream_buffer::stream_buffer (u32 target, u32 segment_size, u32 segments)
+    : m_id (0),
+      m_target (target),
+      m_segment_size (segment_size),
+      m_segment_count (segments),
+      m_segment (0),
+      m_used (0),
+      m_flushed (0),
+      m_mapping (nullptr),
+      m_staging (),
+      m_fences () {
+    glGenBuffers(1, &m_id);
+    bind();
+
+    if (GLAD_GL_VERSION_4_4) {
+      u32 flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+      u64 size = static_cast <u64> (m_segment_size) * m_segment_count;
+
+      glBufferStorage(m_target, size, nullptr, flags);
+      m_mapping = static_cast <byte*> (glMapBufferRange(m_target, 0, size, flags));
+
+      if (m_mapping != nullptr) {
+        m_fences.resize(m_segment_count, nullptr);
+        return;
+      }
+
+      std::cerr << "Failed to map stream buffer, falling back to orphaning" << std::endl;
+
+      // Storage can not be respecified, the fallback needs a new buffer
+      glDeleteBuffers(1, &m_id);
+      glGenBuffers(1, &m_id);
+      bind();
+    }
+
+    // Orphaning gives every frame fresh storage, one segment is enough
+    m_segment_count = 1;
+    m_staging.resize(m_segment_size);
+    glBufferData(m_target, m_segment_size, nullptr, GL_STREAM_DRAW);
+  }
+
+  stream_buffer::~stream_buffer () {
+    for (GLsync fence: m_fences)
+      if (fence != nullptr)
+        glDeleteSync(fence);
+
+    if (m_mapping != nullptr) {
+      bind();
+      glUnmapBuffer(m_target);
+    }
+
+    glDeleteBuffers(1, &m_id);
+  }
+
+  void stream_buffer::bind () const {
+    glBindBuffer(m_target, m_id);
+  }
+
+  void stream_buffer::unbind () const {
+    glBindBuffer(m_target, 0);
+  }
+
+  void* stream_buffer::allocate (u32 size, u32 alignment, u32 &offset) {
+    if (m_used == 0)
+      begin_segment();
+
+    // Aligned within the whole buffer, so offsets divide by a vertex stride
+    // whatever the segment size
+    u64 base = static_cast <u64> (m_segment) * m_segment_size;
+    u64 start = (base + m_used + alignment - 1) / alignment * alignment - base;
+
+    if (start + size > m_segment_size) {
+      std::cerr << "Stream buffer segment of " << m_segment_size << " bytes is full" << std::endl;
+      return nullptr;
+    }
+
+    m_used = start + size;
+    offset = base + start;
+
+    return m_mapping != nullptr ? m_mapping + base + start : m_staging.data() + start;
+  }
+
+  void stream_buffer::flush () {
+    // Coherent mappings are visible as soon as they are written
+    if (m_mapping != nullptr or m_used == m_flushed)
+      return;
+
+    bind();
+    glBufferSubData(m_target, m_flushed, m_used - m_flushed, m_staging.data() + m_flushed);
+    m_flushed = m_used;
+  }
+
+  void stream_buffer::end_frame () {
+    if (m_used == 0)
+      return;
+
+    if (m_mapping != nullptr)
+      m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    m_segment = (m_segment + 1) % m_segment_count;
+    m_used = 0;
+    m_flushed = 0;
+  }
+
+  bool stream_buffer::is_persistent () const {
+    return m_mapping != nullptr;
+  }
+
+  u32 stream_buffer::get_id () const {
+    return m_id;
+  }
+
+  // Waits until the GPU is done with the segment, segments - 1 frames after
+  // it was fenced that is normally the case already. Orphaning hands the old
+  // storage to the driver instead
+  void stream_buffer::begin_segment () {
+    if (m_mapping == nullptr) {
+      bind();
+      glBufferData(m_target, m_segment_size, nullptr, GL_STREAM_DRAW);
+      return;
+    }
+
+    GLsync &fence = m_fences[m_segment];
+
+    if (fence == nullptr)
+      return;
+
+    u32 status;
+
+    do
+      status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, fence_timeout);
+    while (status == GL_TIMEOUT_EXPIRED);
+
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+} // namespace gl
@@ -0,0 +1,70 @@
+#ifndef HEADER_STREAM_BUFFER_H
+#define HEADER_STREAM_BUFFER_H
+
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "types.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // A buffer rewritten every frame, for geometry that changes as often as it
+  // is drawn.
+  //
+  // With buffer storage (GL 4.4) the buffer holds `segments` frames and stays
+  // mapped persistent and coherent. Each frame writes the next segment in
+  // turn, straight into memory the GPU reads, after waiting on the fence
+  // placed when the segment was last drawn from. Without it, every frame
+  // orphans the buffer and flush uploads what was written since
+  class stream_buffer {
+    private:
+      u32 m_id;
+      u32 m_target;
+      u32 m_segment_size;
+      u32 m_segment_count;
+
+      // Segment of the current frame and the bytes of it handed out
+      u32 m_segment;
+      u32 m_used;
+      u32 m_flushed;
+
+      // The persistent mapping of every segment, or nullptr when orphaning
+      byte *m_mapping;
+      std::vector <byte> m_staging;
+      std::vector <GLsync> m_fences;
+
+    public:
+      stream_buffer (u32, u32, u32 = 3);
+      ~stream_buffer ();
+
+      stream_buffer (const stream_buffer&) = delete;
+      stream_buffer& operator = (const stream_buffer&) = delete;
+
+      void bind () const;
+      void unbind () const;
+
+      // Room for `size` bytes aligned to `alignment` in this frame's segment,
+      // nullptr once the segment is full. `offset` is set to where the bytes
+      // are in the buffer
+      void* allocate (u32, u32, u32&);
+
+      // Makes what was written since the last flush visible to draws
+      void flush ();
+
+      // Fences this frame's segment behind the draws reading it and moves on
+      // to the next one. Call after the last draw of the frame
+      void end_frame ();
+
+      bool is_persistent () const;
+      u32 get_id () const;
+
+    private:
+      void begin_segment ();
+  };
+
+} // namespace gl
+
+#endif // HEADER_STREAM_BUFFER_H
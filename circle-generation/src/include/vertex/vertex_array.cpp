@@ -25,7 +25,19 @@ namespace gl {
   void vertex_array::add_buffer (const vertex_buffer& vb, const vertex_buffer_layout& layout) {
     bind();
     vb.bind();
+    set_attributes(layout);
+  }
+
+  // The attributes read the buffer from its start, draws pick the vertices
+  // written this frame with a base vertex
+  void vertex_array::add_buffer (const stream_buffer& sb, const vertex_buffer_layout& layout) {
+    bind();
+    sb.bind();
+    set_attributes(layout);
+  }
 
+  // Points the attributes at the buffer bound to GL_ARRAY_BUFFER
+  void vertex_array::set_attributes (const vertex_buffer_layout& layout) {
     const auto& elements = layout.get_elements();
 
     for (u32 i = 0, offset = 0; i < elements.size(); ++i) {
@@ -4,6 +4,7 @@
 #include "types.hpp"
 #include "vertex_buffer.hpp"
 #include "vertex_buffer_layout.hpp"
+#include "stream_buffer.hpp"
 
 namespace gl {
 
@@ -21,6 +22,10 @@ namespace gl {
       void unbind () const;
 
       void add_buffer (const vertex_buffer&, const vertex_buffer_layout&);
+      void add_buffer (const stream_buffer&, const vertex_buffer_layout&);
+
+    private:
+      void set_attributes (const vertex_buffer_layout&);
   };
 
 } // namespace gl
@@ -7,12 +7,20 @@ namespace gl {
 
   using namespace gl::types;
 
+  // How often the contents of a buffer change, a hint for where the driver
+  // keeps it. Geometry rewritten every frame belongs in a stream_buffer
+  enum class buffer_usage {
+    static_draw,
+    dynamic_draw,
+    stream_draw
+  };
+
   class vertex_buffer {
     private:
       u32 m_id;
 
     public:
-      vertex_buffer (const void*, u32);
+      vertex_buffer (const void*, u32, buffer_usage = buffer_usage::static_draw);
       ~vertex_buffer ();
 
       void bind () const;
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <cstring>
 #include <thread>
 #include <numeric>
 #include <functional>
@@ -135,6 +136,18 @@ int main () {
     shader_program.set_uniform("u_color", globals::draw_color);
 
     renderer.set_draw_mode(gl::draw_mode::triangle);
+
+    // The circle is regenerated every frame, it goes through stream buffers
+    // instead of new buffers per frame. 64 KiB a frame is far more than the
+    // 101 vertices and 303 indices of the largest circle
+    gl::stream_buffer vertex_stream (GL_ARRAY_BUFFER, 64 * 1024);
+    gl::stream_buffer index_stream (GL_ELEMENT_ARRAY_BUFFER, 64 * 1024);
+
+    gl::vertex_array va;
+    gl::vertex_buffer_layout layout;
+
+    layout.push <f32> (3);
+    va.add_buffer(vertex_stream, layout);
     
     glLineWidth(3.0f);
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -152,13 +165,22 @@ int main () {
 
       generate_verticies(n);
 
-      gl::vertex_array va;
-      gl::vertex_buffer_layout layout;
-      gl::vertex_buffer vb (globals::vertices.data(), 3 * sizeof(f32) * globals::vertices.size());
-      gl::index_buffer ib (globals::indices.data(), globals::indices.size());
+      u32 vertex_size = sizeof(glm::vec3) * globals::vertices.size();
+      u32 index_size = sizeof(u32) * globals::indices.size();
+      u32 vertex_offset = 0;
+      u32 index_offset = 0;
 
-      layout.push <f32> (3);
-      va.add_buffer(vb, layout);
+      // Vertices are aligned to their stride, so their offset is a base vertex
+      void *vertices = vertex_stream.allocate(vertex_size, layout.get_stride(), vertex_offset);
+      void *indices = index_stream.allocate(index_size, sizeof(u32), index_offset);
+
+      if (vertices != nullptr and indices != nullptr) {
+        std::memcpy(vertices, globals::vertices.data(), vertex_size);
+        std::memcpy(indices, globals::indices.data(), index_size);
+      }
+
+      vertex_stream.flush();
+      index_stream.flush();
 
       glm::mat4 model = glm::translate(glm::mat4(1.0f), globals::translation);
       glm::mat4 mvp = globals::projection * globals::view * model;
@@ -174,11 +196,18 @@ int main () {
         ImGui::End();
       }
 
-      renderer.draw_elements(va, ib, shader_program);
-      ib.unbind();
-      vb.unbind();
+      if (vertices != nullptr and indices != nullptr) {
+        renderer.draw_elements(
+          va, index_stream, shader_program,
+          index_offset, globals::indices.size(), vertex_offset / layout.get_stride()
+        );
+      }
+
       va.unbind();
 
+      vertex_stream.end_frame();
+      index_stream.end_frame();
+
       ImGui::Render();
       ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
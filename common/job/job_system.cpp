@@ -0,0 +1,301 @@
+#include "job_system.hpp"
+
+namespace gl {
+
+  // The system the running thread belongs to, and its index there
+  static thread_local const job_system *current_system = nullptr;
+  static thread_local u32 current_thread = 0;
+
+  job_counter::job_counter ()
+    : m_count (0),
+      m_mutex (),
+      m_continuations () {
+
+  }
+
+  bool job_counter::is_done () const {
+    return m_count.load() == 0;
+  }
+
+  job_system::job_system (u32 thread_count)
+    : m_queues (),
+      m_threads (),
+      m_main_thread (std::this_thread::get_id()),
+      m_queued (0),
+      m_sleeping (0),
+      m_sleep_mutex (),
+      m_wake (),
+      m_stopping (false),
+      m_main_jobs (),
+      m_main_mutex () {
+
+    if (thread_count == 0)
+      thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+    for (u32 i = 0; i < thread_count; ++i)
+      m_queues.push_back(std::make_unique <thread_queue> ());
+
+    current_system = this;
+    current_thread = 0;
+
+    m_threads.reserve(thread_count - 1);
+
+    for (u32 i = 1; i < thread_count; ++i)
+      m_threads.emplace_back(&job_system::work, this, i);
+  }
+
+  job_system::~job_system () {
+    // Without workers nobody else would run them
+    if (m_threads.empty())
+      while (run_one());
+
+    {
+      std::lock_guard lock (m_sleep_mutex);
+      m_stopping = true;
+    }
+
+    m_wake.notify_all();
+
+    for (auto &thread: m_threads)
+      thread.join();
+
+    if (current_system == this)
+      current_system = nullptr;
+  }
+
+  void job_system::spawn (std::function <void ()> &&function, job_counter *counter) {
+    if (counter != nullptr)
+      ++counter->m_count;
+
+    push({std::move(function), counter});
+  }
+
+  void job_system::spawn_after (job_counter &dependency, std::function <void ()> &&function, job_counter *counter) {
+    if (counter != nullptr)
+      ++counter->m_count;
+
+    {
+      std::lock_guard lock (dependency.m_mutex);
+
+      if (dependency.m_count.load() > 0) {
+        dependency.m_continuations.push_back({std::move(function), counter});
+        return;
+      }
+    }
+
+    push({std::move(function), counter});
+  }
+
+  void job_system::spawn_main (std::function <void ()> &&function, job_counter *counter) {
+    if (counter != nullptr)
+      ++counter->m_count;
+
+    std::lock_guard lock (m_main_mutex);
+    m_main_jobs.push_back({std::move(function), counter});
+  }
+
+  u32 job_system::run_main () {
+    if (std::this_thread::get_id() != m_main_thread)
+      return 0;
+
+    std::deque <job> jobs;
+
+    {
+      std::lock_guard lock (m_main_mutex);
+      jobs.swap(m_main_jobs);
+    }
+
+    for (auto &j: jobs)
+      execute(j);
+
+    return jobs.size();
+  }
+
+  void job_system::wait (job_counter &counter) {
+    bool is_main = std::this_thread::get_id() == m_main_thread;
+
+    while (counter.m_count.load() > 0) {
+      if (is_main and run_main() > 0)
+        continue;
+
+      if (not run_one())
+        std::this_thread::yield();
+    }
+
+    // The job that brought it to zero may still hold the mutex, the counter
+    // must outlive that
+    std::lock_guard lock (counter.m_mutex);
+  }
+
+  u32 job_system::get_thread_count () const {
+    return m_queues.size();
+  }
+
+  std::vector <job_system::thread_statistics> job_system::get_statistics () const {
+    std::vector <thread_statistics> statistics;
+
+    for (auto &queue: m_queues)
+      statistics.push_back({queue->m_executed.load(), queue->m_stolen.load()});
+
+    return statistics;
+  }
+
+  void job_system::reset_statistics () {
+    for (auto &queue: m_queues) {
+      queue->m_executed = 0;
+      queue->m_stolen = 0;
+    }
+  }
+
+  // Onto the deque of the calling thread, threads outside the system share
+  // the one of the main thread
+  void job_system::push (job &&j) {
+    u32 thread = get_current_thread();
+    thread_queue &queue = *m_queues[thread == no_thread ? 0 : thread];
+
+    {
+      std::lock_guard lock (queue.m_mutex);
+      queue.m_jobs.push_back(std::move(j));
+    }
+
+    // Pairs with the m_sleeping increment in work: either the worker sees
+    // the job, or this sees the worker and wakes it
+    ++m_queued;
+
+    if (m_sleeping.load() > 0) {
+      std::lock_guard lock (m_sleep_mutex);
+      m_wake.notify_one();
+    }
+  }
+
+  bool job_system::run_one () {
+    u32 thread = get_current_thread();
+    u32 count = m_queues.size();
+    job j;
+
+    if (thread != no_thread and pop(thread, j)) {
+      execute(j);
+      return true;
+    }
+
+    u32 first = thread == no_thread ? 0 : thread + 1;
+
+    for (u32 i = 0; i < count; ++i) {
+      u32 victim = (first + i) % count;
+
+      if (victim != thread and steal(victim, j)) {
+        if (thread != no_thread)
+          ++m_queues[thread]->m_stolen;
+
+        execute(j);
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  bool job_system::pop (u32 thread, job &j) {
+    thread_queue &queue = *m_queues[thread];
+    std::lock_guard lock (queue.m_mutex);
+
+    if (queue.m_jobs.empty())
+      return false;
+
+    j = std::move(queue.m_jobs.back());
+    queue.m_jobs.pop_back();
+    --m_queued;
+    return true;
+  }
+
+  bool job_system::steal (u32 victim, job &j) {
+    thread_queue &queue = *m_queues[victim];
+    std::lock_guard lock (queue.m_mutex);
+
+    if (queue.m_jobs.empty())
+      return false;
+
+    j = std::move(queue.m_jobs.front());
+    queue.m_jobs.pop_front();
+    --m_queued;
+    return true;
+  }
+
+  void job_system::execute (job &j) {
+    j.m_function();
+
+    if (u32 thread = get_current_thread(); thread != no_thread)
+      m_queues[thread]->m_executed.fetch_add(1, std::memory_order_relaxed);
+
+    finish(j.m_counter);
+  }
+
+  // Only the decrement to zero takes the counter's mutex, so it can not race
+  // spawn_after adding a continuation
+  void job_system::finish (job_counter *counter) {
+    if (counter == nullptr)
+      return;
+
+    u32 count = counter->m_count.load();
+
+    while (count > 1)
+      if (counter->m_count.compare_exchange_weak(count, count - 1))
+        return;
+
+    std::vector <job> continuations;
+
+    {
+      std::lock_guard lock (counter->m_mutex);
+
+      if (counter->m_count.fetch_sub(1) == 1)
+        continuations.swap(counter->m_continuations);
+    }
+
+    for (auto &j: continuations)
+      push(std::move(j));
+  }
+
+  void job_system::work (u32 thread) {
+    current_system = this;
+    current_thread = thread;
+
+    while (true) {
+      if (run_one())
+        continue;
+
+      ++m_sleeping;
+
+      {
+        std::unique_lock lock (m_sleep_mutex);
+        m_wake.wait(lock, [this] { return m_stopping or m_queued.load() > 0; });
+
+        if (m_stopping and m_queued.load() == 0) {
+          --m_sleeping;
+          return;
+        }
+      }
+
+      --m_sleeping;
+    }
+  }
+
+  u32 job_system::get_current_thread () const {
+    return current_system == this ? current_thread : no_thread;
+  }
+
+  // Keeps the lower half and leaves the upper one to whoever takes it first
+  void job_system::split (u32 begin, u32 end, u32 grain, const std::function <void (u32, u32)> &function, job_counter &counter) {
+    while (end - begin > grain) {
+      u32 middle = begin + (end - begin) / 2;
+
+      spawn([this, middle, end, grain, &function, &counter] {
+        split(middle, end, grain, function, counter);
+      }, &counter);
+
+      end = middle;
+    }
+
+    function(begin, end);
+  }
+
+} // namespace gl
@@ -0,0 +1,155 @@
+#ifndef HEADER_JOB_JOB_SYSTEM_H
+#define HEADER_JOB_JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "types.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  class job_counter;
+
+  struct job {
+    std::function <void ()> m_function;
+    job_counter *m_counter;
+  };
+
+  // How many jobs spawned with it have not finished yet. job_system::wait
+  // returns once it is zero, and jobs spawned after it start once it is.
+  // A counter may be reused, but not while jobs wait on it
+  class job_counter {
+    private:
+      friend class job_system;
+
+      std::atomic <u32> m_count;
+
+      // Guards reaching zero against spawn_after, see job_system::finish
+      std::mutex m_mutex;
+      std::vector <job> m_continuations;
+
+    public:
+      job_counter ();
+
+      job_counter (const job_counter&) = delete;
+      job_counter& operator = (const job_counter&) = delete;
+
+      bool is_done () const;
+  };
+
+  // A work stealing scheduler. Every thread has a deque of jobs: it pushes
+  // and pops its own jobs at the back, and when it runs out, steals the
+  // oldest job, at the front, of another thread. Old jobs tend to be the
+  // large halves parallel_for has not split yet, so a steal moves a lot of
+  // work at once.
+  //
+  // The thread that makes the system is one of its threads: it runs jobs
+  // while it waits, and it alone runs the jobs of spawn_main, which is where
+  // GL work goes. Threads outside the system may spawn and wait too, they
+  // only steal
+  class job_system {
+    public:
+      struct thread_statistics {
+        u64 m_executed;
+        u64 m_stolen;
+      };
+
+    private:
+      static constexpr u32 no_thread = ~0u;
+
+      // One cache line each, the counters are written on every job
+      struct alignas(64) thread_queue {
+        std::deque <job> m_jobs;
+        std::mutex m_mutex;
+        std::atomic <u64> m_executed;
+        std::atomic <u64> m_stolen;
+      };
+
+      std::vector <std::unique_ptr <thread_queue>> m_queues;
+      std::vector <std::thread> m_threads;
+      std::thread::id m_main_thread;
+
+      // Jobs in the deques, and workers asleep waiting for one
+      std::atomic <u32> m_queued;
+      std::atomic <u32> m_sleeping;
+      std::mutex m_sleep_mutex;
+      std::condition_variable m_wake;
+      bool m_stopping;
+
+      std::deque <job> m_main_jobs;
+      std::mutex m_main_mutex;
+
+    public:
+      // Threads including the calling one, 0 picks one per hardware thread
+      job_system (u32 = 0);
+
+      // Runs the jobs still queued before it returns
+      ~job_system ();
+
+      job_system (const job_system&) = delete;
+      job_system& operator = (const job_system&) = delete;
+
+      void spawn (std::function <void ()>&&, job_counter* = nullptr);
+
+      // Spawns the job once the first counter reaches zero, right away if it
+      // is zero already
+      void spawn_after (job_counter&, std::function <void ()>&&, job_counter* = nullptr);
+
+      // For the thread that made the system only, see run_main
+      void spawn_main (std::function <void ()>&&, job_counter* = nullptr);
+
+      // Runs the jobs of spawn_main. Call once per frame on the main thread
+      u32 run_main ();
+
+      // Runs other jobs until the counter is zero
+      void wait (job_counter&);
+
+      // Calls function(first, last) over [begin, end) in ranges of at most
+      // `grain` indices, on every thread, and returns when all are done.
+      // Ranges are split in halves, so the first steals take large ones
+      template <typename function_type>
+      void parallel_for (u32, u32, u32, function_type&&);
+
+      u32 get_thread_count () const;
+
+      // Per thread, the one that made the system first
+      std::vector <thread_statistics> get_statistics () const;
+      void reset_statistics ();
+
+    private:
+      void push (job&&);
+      bool run_one ();
+      bool pop (u32, job&);
+      bool steal (u32, job&);
+      void execute (job&);
+      void finish (job_counter*);
+      void work (u32);
+      u32 get_current_thread () const;
+
+      void split (u32, u32, u32, const std::function <void (u32, u32)>&, job_counter&);
+  };
+
+  template <typename function_type>
+  void job_system::parallel_for (u32 begin, u32 end, u32 grain, function_type &&function) {
+    if (begin >= end)
+      return;
+
+    job_counter counter;
+    std::function <void (u32, u32)> range = [&function] (u32 first, u32 last) { function(first, last); };
+
+    split(begin, end, std::max(grain, 1u), range, counter);
+    wait(counter);
+  }
+
+} // namespace gl
+
+#endif // HEADER_JOB_JOB_SYSTEM_H
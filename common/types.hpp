@@ -23,6 +23,12 @@ namespace gl {
     using f64 = double;
     using f128 = long double;
 
+    // IEEE 754 half precision float, only ever stored (see to_f16 in
+    // interactive-objects' vertex/vertex_format.hpp) and read by the GPU
+    struct f16 {
+      u16 m_bits;
+    };
+
   } // namespace types
 
 } // namespace gl
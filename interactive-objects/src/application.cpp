@@ -1,7 +1,13 @@
-#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
 #include <fstream>
-#include <sstream>
+#include <iostream>
+#include <limits>
 #include <random>
+#include <string>
+#include <thread>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -14,7 +20,14 @@
 #include <imgui/backends/imgui_impl_opengl3.h>
 
 #include "application.hpp"
+#include "framebuffer.hpp"
 #include "scene.hpp"
+#include "shader/frame_uniforms.hpp"
+#include "mesh/obj_loader.hpp"
+#include "mesh/mesh_cache.hpp"
+#include "mesh/mesh_optimizer.hpp"
+#include "mesh/mesh_simplifier.hpp"
+#include "asset/task.hpp"
 
 namespace gl {
 
@@ -27,26 +40,85 @@ namespace gl {
   static std::unique_ptr <gl::scene> create_scene_rectangle (u32, u32, u32);
   static std::unique_ptr <gl::scene> create_scene_cuboid (u32, u32, u32);
   static std::unique_ptr <gl::scene> create_scene_circle (u32, u32, u32);
-  static std::unique_ptr <gl::scene> create_scene_sphere (u32, u32, u32);
-  static std::unique_ptr <gl::scene> create_scene_torus (u32, u32, u32);
-  static std::unique_ptr <gl::scene> create_scene_suzanne (u32, u32, u32);
-  static std::unique_ptr <gl::scene> create_scene_klein_bottle (u32, u32, u32);
-  static std::unique_ptr <gl::scene> create_scene_planetary_gear (u32, u32, u32);
-  static std::unique_ptr <gl::scene> create_scene_assignment (u32, u32, u32);
+  static std::unique_ptr <gl::scene> create_scene_sphere (asset_streamer&, mesh_registry&, palette_buffer&, u32, u32, u32);
+  static std::unique_ptr <gl::scene> create_scene_torus (asset_streamer&, mesh_registry&, palette_buffer&, u32, u32, u32);
+  static std::unique_ptr <gl::scene> create_scene_suzanne (asset_streamer&, mesh_registry&, palette_buffer&, u32, u32, u32);
+  static std::unique_ptr <gl::scene> create_scene_klein_bottle (asset_streamer&, mesh_registry&, palette_buffer&, u32, u32, u32);
+  static std::unique_ptr <gl::scene> create_scene_planetary_gear (asset_streamer&, mesh_registry&, palette_buffer&, u32, u32, u32);
+  static std::unique_ptr <gl::scene> create_scene_assignment (asset_streamer&, mesh_registry&, palette_buffer&, u32, u32, u32);
+  static std::unique_ptr <gl::scene> create_scene_stress (asset_streamer&, mesh_registry&, palette_buffer&, u32, u32, u32, u32);
 
   static void circle_generate (object&, u32, u32, u32, u32);
   static glm::vec3 rotate_point (glm::vec3, glm::vec3, f32);
 
-  static std::unique_ptr <gl::object> load_blender_obj (const std::string&, const std::string&, const std::vector <glm::vec3>&);
-
-  application::application (u32 width, u32 height, u32 depth, const std::string &name)
+  // Interleaved (position, palette index) vertices in mesh_vertex_format, indices,
+  // levels of detail and bounds of an OBJ, ready for object::load.
+  //
+  // On a cache hit the vertices and indices are read in place from the
+  // mapped cache, which stays open as long as the mesh. Only a parsed mesh
+  // keeps them in the vectors
+  struct blender_mesh {
+    mesh_cache m_cache;
+    std::vector <byte> m_vertices;
+    std::vector <u32> m_indices;
+    std::vector <mesh_lod> m_lods;
+    bounding_box m_bounds;
+    glm::vec4 m_bounding_sphere = glm::vec4(0.0f);
+
+    const void* get_vertex_data () const;
+    u32 get_vertex_size () const;
+    const u32* get_index_data () const;
+    u32 get_index_count () const;
+  };
+
+  // Half the memory and bandwidth of vertex_format::full, and more precise
+  // than vertex_format::half for positions within the bounding box
+  static constexpr vertex_format mesh_vertex_format = vertex_format::snorm16;
+
+  // Spheres of the stress scene, which measures how drawing and updating
+  // scale with the object count
+  static constexpr u32 stress_object_count = 100000;
+
+  // The Rendered Objects panel lists this many objects of a scene at most
+  static constexpr u32 max_listed_objects = 64;
+
+  // Frames F2 writes to a trace file
+  static constexpr u32 trace_frames = 60;
+
+  // Headless runs step time by a fixed amount and seed the scenes the same
+  // way, so two runs render the same frames
+  static constexpr f32 headless_delta_time = 1.0f / 60.0f;
+  static constexpr u32 headless_seed = 42;
+
+  // Simulation ticks per second, independent of the frame rate. Angular
+  // velocities are per tick, so this is also how fast objects spin
+  static constexpr f32 simulation_tick_rate = 60.0f;
+
+  // Objects per job of cull_objects, a multiple of the SIMD width
+  static constexpr u32 cull_block = 4096;
+
+  // Texture unit of the palettes, the renderer keeps unit 0 for the draws
+  static constexpr u32 palette_texture_unit = 1;
+
+  static std::unique_ptr <gl::object> load_blender_obj (asset_streamer&, mesh_registry&, palette_buffer&, const std::string&, const std::string&, const std::vector <glm::vec3>&);
+  static async_result <blender_mesh> load_mesh (asset_streamer&, const std::string&, vertex_format);
+  static draw_packet object_packet (const draw_program&, const object&);
+  static task stream_mesh (asset_streamer&, std::shared_ptr <gpu_mesh>, std::string);
+  static bool write_ppm (const std::string&, const framebuffer&);
+
+  application::application (u32 width, u32 height, u32 depth, const std::string &name, bool headless)
     : m_width (width),
       m_height (height),
       m_depth (depth),
       m_name (name),
       m_window (nullptr),
       m_running (true),
+      m_headless (headless),
       m_shader_program (nullptr),
+      m_frame_uniforms (nullptr),
+      m_draw_program (),
+      m_instanced_shader_program (nullptr),
+      m_instanced_draw_program (),
       m_camera (glm::vec3((f32)m_width / 2, (f32)m_height / 2, 0.0f)),
       m_delta_time (0.0f),
       m_last_frame (0.0f),
@@ -61,11 +133,55 @@ namespace gl {
       m_display_wireframe (false),
       m_display_depth_test (true),
       m_display_smooth_lines (true),
+      m_lod_threshold (1.0f),
+      m_render_queue (),
+      m_render_graph (),
+      m_grid_pass (m_render_graph.add_pass({
+        "Grid", {draw_mode::line, GL_FILL, 1.0f, 0x00, false},
+        color_resource | depth_resource
+      })),
+      m_wireframe_pass (m_render_graph.add_pass({
+        "Wireframe", {draw_mode::triangle, GL_LINE, 1.0f, 0x00, false},
+        color_resource | depth_resource
+      })),
+      m_outline_pass (m_render_graph.add_pass({
+        "Outline", {draw_mode::triangle, GL_LINE, 2.5f, 0x00, false},
+        color_resource | depth_resource
+      })),
+      m_opaque_pass (m_render_graph.add_pass({
+        "Opaque", {draw_mode::triangle, GL_FILL, 1.0f, 0x00, false},
+        color_resource | depth_resource | stencil_resource
+      })),
+      m_blended_pass (m_render_graph.add_pass({
+        "Blended", {draw_mode::triangle, GL_FILL, 1.0f, 0x00, true},
+        color_resource | depth_resource | stencil_resource
+      })),
+      m_highlight_pass (m_render_graph.add_pass({
+        "Highlight", {draw_mode::triangle, GL_FILL, 1.0f, 0x00, true},
+        color_resource
+      })),
+      m_instance_batches (),
+      m_mesh_users (),
       m_key_pressed (m_key_count),
+      m_job_system (),
+      m_asset_streamer (m_job_system),
+      m_mesh_registry (),
+      m_palettes (),
+      m_profiler (),
+      m_culler (),
+      m_visible_count (0),
+      m_culled_count (0),
       m_scenes (),
       m_scene_index (1),
-      m_selected_object_index (-1)
+      m_selected_object_index (-1),
+      m_simulation (m_job_system, simulation_tick_rate)
   {
+#ifdef GLFW_PLATFORM_NULL
+    // GLFW 3.4 and later need no display server for a headless context
+    if (m_headless)
+      glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -74,7 +190,24 @@ namespace gl {
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
     
-    m_window = glfwCreateWindow(m_width, m_height, m_name.c_str(), nullptr, nullptr);
+    if (m_headless) {
+      glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+      // EGL can make surfaceless contexts, OSMesa renders on the CPU when
+      // there is no GPU at all (e.g. Mesa's llvmpipe)
+      for (i32 api: {GLFW_EGL_CONTEXT_API, GLFW_OSMESA_CONTEXT_API}) {
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, api);
+        m_window = glfwCreateWindow(m_width, m_height, m_name.c_str(), nullptr, nullptr);
+
+        if (m_window != nullptr)
+          break;
+      }
+
+      mt.seed(headless_seed);
+    }
+    else {
+      m_window = glfwCreateWindow(m_width, m_height, m_name.c_str(), nullptr, nullptr);
+    }
 
     if (m_window == nullptr) {
       std::cerr << "Failed to create GLFW window!" << std::endl;
@@ -89,7 +222,8 @@ namespace gl {
     }
 
     glfwSetWindowUserPointer(m_window, this);
-    glfwSwapInterval(1);
+    // Headless frames are timed, waiting for vertical sync would hide them
+    glfwSwapInterval(m_headless ? 0 : 1);
 
     glEnable(GL_DEPTH_TEST);
 
@@ -105,6 +239,9 @@ namespace gl {
 
     create_grid();
 
+    if (m_headless)
+      return;
+
     ImGui::CreateContext();
     ImGui::StyleColorsDark();
 
@@ -113,9 +250,11 @@ namespace gl {
   }
 
   application::~application () {
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
+    if (not m_headless) {
+      ImGui_ImplOpenGL3_Shutdown();
+      ImGui_ImplGlfw_Shutdown();
+      ImGui::DestroyContext();
+    }
 
     glfwDestroyWindow(m_window);
     glfwTerminate();
@@ -127,12 +266,106 @@ namespace gl {
 
   void application::run () {
     while (m_running) {
-      glfwPollEvents();
+      m_profiler.begin_frame();
+
+      PROFILE_SCOPE(m_profiler, "Frame");
+
+      {
+        PROFILE_SCOPE(m_profiler, "Input");
+        glfwPollEvents();
+      }
+
       on_update();
-      glfwSwapBuffers(m_window);
+
+      {
+        PROFILE_SCOPE(m_profiler, "Swap");
+        glfwSwapBuffers(m_window);
+      }
     }
   }
 
+  void application::run_headless (u32 frames, const std::string &output_directory) {
+    using clock = std::chrono::steady_clock;
+
+    // The size of the window, so the projection and LOD selection match
+    framebuffer target (m_width, m_height);
+
+    if (not target.is_complete()) {
+      std::cerr << "Failed to create the offscreen framebuffer!" << std::endl;
+      return;
+    }
+
+    if (frames == 0)
+      return;
+
+    std::printf("%ux%u, %u frames per scene, vsync off\n", m_width, m_height, frames);
+    std::printf(
+      "%-20s %9s %9s %9s %9s %9s %9s\n",
+      "scene", "objects", "avg ms", "p50 ms", "p99 ms", "max ms", "fps"
+    );
+
+    for (i32 index = 0; index < (i32)m_scenes.size(); ++index) {
+      auto &scene = *m_scenes[index];
+      m_scene_index = index;
+
+      // Frames are measured once every mesh of the scene is resident
+      while (m_asset_streamer.get_pending_count() > 0) {
+        m_asset_streamer.poll();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+
+      target.bind();
+      set_view_port(0, 0, m_width, m_height);
+
+      std::vector <f64> times;
+      times.reserve(frames);
+
+      for (u32 frame = 0; frame < frames; ++frame) {
+        clock::time_point begin = clock::now();
+
+        m_profiler.begin_frame();
+
+        {
+          PROFILE_SCOPE(m_profiler, "Frame");
+          on_update();
+        }
+
+        // Nothing swaps, so the frame is only done once the GPU is
+        glFinish();
+
+        times.push_back(std::chrono::duration <f64, std::milli> (clock::now() - begin).count());
+      }
+
+      f64 total = 0.0;
+
+      for (f64 time: times)
+        total += time;
+
+      std::sort(times.begin(), times.end());
+
+      auto percentile = [&] (f64 p) {
+        return times[std::min <u64> (times.size() - 1, static_cast <u64> (p * times.size()))];
+      };
+
+      f64 average = total / times.size();
+
+      std::printf(
+        "%-20s %9zu %9.3f %9.3f %9.3f %9.3f %9.1f\n",
+        scene.get_name().c_str(), scene.get_objects().size(),
+        average, percentile(0.5), percentile(0.99), times.back(), 1000.0 / average
+      );
+
+      if (not output_directory.empty()) {
+        std::string file_name = scene.get_name();
+        std::replace(file_name.begin(), file_name.end(), ' ', '-');
+
+        write_ppm(output_directory + "/" + file_name + ".ppm", target);
+      }
+    }
+
+    target.unbind();
+  }
+
   void application::on_resize (i32 width, i32 height) {
     m_width = width;
     m_height = height;
@@ -189,11 +422,15 @@ namespace gl {
           m_selected_object_index = stencil_index - 1;
           
           auto &o = m_scenes[m_scene_index]->get_objects()[m_selected_object_index];
-          
-          m_cached_velocity = o->get_velocity();
-          m_cached_rotation_angles = o->get_rotation_angles();
-          o->set_velocity({0, 0, 0});
-          o->set_rotation_angles({0, 0, 0});
+          u32 slot = o->get_transform_index();
+
+          // The simulation owns the motion, the object only what is drawn
+          m_simulation.post(*m_scenes[m_scene_index], [this, slot] (transform_storage &state) {
+            m_cached_velocity = state.get_velocity(slot);
+            m_cached_rotation_angles = state.get_angular_velocity(slot);
+            state.set_velocity(slot, glm::vec3(0.0f));
+            state.set_angular_velocity(slot, glm::vec3(0.0f));
+          });
         }
       }
       else {
@@ -201,9 +438,12 @@ namespace gl {
           return;
         
         auto &o = m_scenes[m_scene_index]->get_objects()[m_selected_object_index];
-        
-        o->set_velocity(m_cached_velocity);
-        o->set_rotation_angles(m_cached_rotation_angles);
+        u32 slot = o->get_transform_index();
+
+        m_simulation.post(*m_scenes[m_scene_index], [this, slot] (transform_storage &state) {
+          state.set_velocity(slot, m_cached_velocity);
+          state.set_angular_velocity(slot, m_cached_rotation_angles);
+        });
         
         m_selected_object_index = -1;
       }
@@ -237,7 +477,12 @@ namespace gl {
 
     if (m_selected_object_index != -1) {
       auto &o = m_scenes[m_scene_index]->get_objects()[m_selected_object_index];
-      o->translate({x_offset / 2.0f, y_offset / 2.0f, 0.0f});
+      u32 slot = o->get_transform_index();
+      glm::vec3 offset (x_offset / 2.0f, y_offset / 2.0f, 0.0f);
+
+      m_simulation.post(*m_scenes[m_scene_index], [slot, offset] (transform_storage &state) {
+        state.set_position(slot, state.get_position(slot) + offset);
+      });
     }
     
     if (m_should_camera_move)
@@ -258,9 +503,23 @@ namespace gl {
   }
 
   void application::on_update () {
-    keypress_update();
+    {
+      PROFILE_SCOPE(m_profiler, "Input");
+      keypress_update();
+    }
 
-    f32 current_frame = static_cast <float> (glfwGetTime());
+    {
+      // Uploads the meshes the asset streamer finished parsing since last
+      // frame, and runs whatever else jobs left for the GL thread
+      PROFILE_SCOPE(m_profiler, "Asset streaming");
+      m_asset_streamer.poll();
+      m_job_system.run_main();
+    }
+
+    // The uploads above bind buffers behind the renderer's back
+    begin_frame();
+
+    f32 current_frame = m_headless ? m_last_frame + headless_delta_time : static_cast <float> (glfwGetTime());
     m_delta_time = current_frame - m_last_frame;
     m_last_frame = current_frame;
 
@@ -268,135 +527,197 @@ namespace gl {
     glClearColor(clear_color.r, clear_color.g, clear_color.b, clear_color.a);
     clear();
 
-    auto projection = m_camera.get_projection((f32)m_width / (f32)m_height, 1.0f, (f32)m_depth);
-    auto view = m_camera.get_view();
-    glm::mat4 model (1.0f);
+    frame_uniforms frame;
+    frame.m_view = m_camera.get_view();
+    frame.m_projection = m_camera.get_projection((f32)m_width / (f32)m_height, 1.0f, (f32)m_depth);
+    frame.m_view_projection = frame.m_projection * frame.m_view;
+    frame.m_camera_position = glm::vec4(m_camera.get_position(), 1.0f);
+    frame.m_viewport = glm::vec2(m_width, m_height);
+    frame.m_time = current_frame;
+    frame.m_delta_time = m_delta_time;
+    m_frame_uniforms->update(&frame);
+
+    set_capability(GL_DEPTH_TEST, m_display_depth_test);
+    set_capability(GL_LINE_SMOOTH, m_display_smooth_lines);
+
+    // View space depth of an object, relative to the far plane
+    auto depth_of = [&] (const object &o) {
+      glm::vec4 sphere = o.get_bounding_sphere();
+      return -(frame.m_view * glm::vec4(glm::vec3(sphere), 1.0f)).z / m_depth;
+    };
 
-    m_shader_program->bind();
-    m_shader_program->set_uniform("u_model", model);
-    m_shader_program->set_uniform("u_view", view);
-    m_shader_program->set_uniform("u_projection", projection);
-    m_shader_program->set_uniform("u_color", glm::vec4 {0, 0, 0, 1});
-    m_shader_program->set_uniform("u_use_vertex_color", true);
-
-    (m_display_depth_test ? glEnable : glDisable)(GL_DEPTH_TEST);
-    (m_display_smooth_lines ? glEnable: glDisable)(GL_LINE_SMOOTH);
-    
-    glStencilMask(0x00);
-    glStencilFunc(GL_ALWAYS, 0, 0xff);
+    // Visual modes turn passes on and off, draws only go to active passes
+    m_render_graph.set_enabled(m_grid_pass, m_display_grid);
+    m_render_graph.set_enabled(m_wireframe_pass, m_display_wireframe);
+    m_render_graph.set_enabled(m_outline_pass, m_display_outline and not m_display_wireframe);
+    m_render_graph.set_enabled(m_opaque_pass, not m_display_wireframe);
+    m_render_graph.set_enabled(m_blended_pass, not m_display_wireframe);
+    m_render_graph.set_enabled(m_highlight_pass, not m_display_wireframe and m_selected_object_index >= 0);
 
-    if (m_display_grid) {
-      glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-      
-      set_draw_mode(draw_mode::line);
-      m_shader_program->set_uniform("u_blend", m_grid->get_blend());
-      draw_elements(
-        m_grid->get_vertex_array(),
-        m_grid->get_index_buffer(),
-        *m_shader_program
-      );
-    }
+    m_render_graph.compile(m_render_queue);
+
+    m_profiler.begin_cpu("Build queue");
+    m_render_queue.clear();
 
-    set_draw_mode(draw_mode::triangle);
+    auto submit = [&] (u32 pass, draw_packet packet, f32 depth) {
+      if (not m_render_graph.is_active(pass))
+        return;
+
+      packet.m_pass = m_render_graph.get_queue_pass(pass);
+      m_render_queue.submit(packet, depth);
+    };
+
+    submit(m_grid_pass, {
+      0, &m_draw_program,
+      &m_grid->get_vertex_array(), &m_grid->get_index_buffer(),
+      m_grid->get_mesh().get_allocation().m_first_index, m_grid->get_mesh().get_allocation().m_index_count,
+      m_grid->get_mesh().get_allocation().m_base_vertex,
+      m_grid->get_model(), m_grid->get_blend(), glm::vec4 {0, 0, 0, 1}, true, {0, 0}, 0, 0
+    }, 0.0f);
 
     if (m_scene_index >= 0 and m_scene_index < (i32)m_scenes.size()) {
       auto &scene = *m_scenes[m_scene_index];
 
-      if (m_display_wireframe) {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+      {
+        // Waits only when the simulation thread fell behind the frame
+        PROFILE_SCOPE(m_profiler, "Simulation");
 
-        for (auto &o: scene.get_objects()) {
-          if (!o->m_should_render)
-            continue;
-          
-          model = o->get_model();
-          m_shader_program->set_uniform("u_model", model);
-          draw_elements(
-            o->get_vertex_array(),
-            o->get_index_buffer(),
-            *m_shader_program
-          );
-        }
+        // Meshes that finished streaming in give their objects a collider
+        if (auto colliders = scene.update_colliders(); not colliders.empty())
+          m_simulation.post(scene, [colliders = std::move(colliders)] (transform_storage &state) {
+            for (const auto &[slot, collider]: colliders)
+              state.set_collider(slot, collider);
+          });
 
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        if (m_simulation.get_scene() != &scene)
+          m_simulation.start(scene, current_frame);
+
+        m_simulation.interpolate(current_frame);
       }
-      else {
-        if (m_display_outline) {
-          glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-
-          m_shader_program->set_uniform("u_use_vertex_color", false);
-          glLineWidth(2.5f);
-
-          for (auto &o: scene.get_objects()) {
-            if (!o->m_should_render)
-              continue;
-            
-            model = o->get_model();
-            m_shader_program->set_uniform("u_model", model);
-
-            draw_elements(
-              o->get_vertex_array(),
-              o->get_index_buffer(),
-              *m_shader_program
-            );
+
+      {
+        PROFILE_SCOPE(m_profiler, "Transforms");
+        scene.update_transforms(m_job_system);
+      }
+
+      {
+        PROFILE_SCOPE(m_profiler, "Culling");
+        cull_objects(scene, frame.m_view_projection);
+      }
+
+      select_lods(scene);
+
+      const auto &objects = scene.get_objects();
+      m_mesh_users.clear();
+
+      for (u32 index = 0; index < objects.size(); ++index)
+        if (m_culler.is_visible(index))
+          ++m_mesh_users[&objects[index]->get_mesh()];
+
+      for (u32 index = 0; index < objects.size(); ++index) {
+        if (not m_culler.is_visible(index))
+          continue;
+
+        auto &o = objects[index];
+
+        u32 fill_pass = o->get_blend() < 1.0f ? m_blended_pass : m_opaque_pass;
+
+        if (m_mesh_users[&o->get_mesh()] >= m_min_instances) {
+          const gpu_mesh *mesh = &o->get_mesh();
+          const color_palette &palette = o->get_palette();
+          instance_data instance {
+            o->get_model(), glm::vec4 {0, 0, 0, 1},
+            glm::vec4 {o->get_blend(), 1.0f, static_cast <f32> (palette.m_offset), static_cast <f32> (palette.m_size)}
+          };
+
+          for (u32 pass: {m_wireframe_pass, fill_pass})
+            if (m_render_graph.is_active(pass))
+              m_instance_batches[{mesh, o->get_lod_index(), pass}].add(instance);
+
+          if (m_render_graph.is_active(m_outline_pass)) {
+            instance.m_parameters.y = 0.0f;
+            m_instance_batches[{mesh, o->get_lod_index(), m_outline_pass}].add(instance);
           }
 
-          glLineWidth(1.0f);
-          m_shader_program->set_uniform("u_use_vertex_color", true);
-          
-          glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+          continue;
         }
 
-        for (i32 index = 0; auto &o: scene.get_objects()) {
-          if (!o->m_should_render)
-            continue;
-          
-          model = o->get_model();
-          m_shader_program->set_uniform("u_model", model);
-          m_shader_program->set_uniform("u_blend", o->get_blend());
+        f32 depth = depth_of(*o);
+        draw_packet packet = object_packet(m_draw_program, *o);
 
-          glStencilMask(0xff);
-          glStencilFunc(GL_ALWAYS, index + 1, 0xff);
-          
-          draw_elements(
-            o->get_vertex_array(),
-            o->get_index_buffer(),
-            *m_shader_program
-          );
-
-          glStencilMask(0x00);
-          glStencilFunc(GL_ALWAYS, index + 1, 0xff);
-
-          if (m_selected_object_index == index) {
-            // std::cout << m_selected_object_index << '\n';
-            
-            const f32 scale_factor = 1.1f;
-            
-            m_shader_program->set_uniform("u_color", glm::vec4 {1.0f, 1.0f, 0.4f, 0.6f});
-            m_shader_program->set_uniform("u_use_vertex_color", false);
-            o->scale(glm::vec3(scale_factor));
-            model = o->get_model();
-            m_shader_program->set_uniform("u_model", model);
-
-            draw_elements(
-              o->get_vertex_array(),
-              o->get_index_buffer(),
-              *m_shader_program
-            );
-
-            o->scale(glm::vec3(1.0f / scale_factor));
-            m_shader_program->set_uniform("u_color", glm::vec4 {0, 0, 0, 1});
-            m_shader_program->set_uniform("u_use_vertex_color", true);
-          }
+        submit(m_wireframe_pass, packet, depth);
+
+        draw_packet outline = packet;
+        outline.m_use_vertex_color = false;
+        submit(m_outline_pass, outline, depth);
+
+        // The stencil value is what on_mouseclick picks objects by, their
+        // index in the scene whether or not the ones before are drawn
+        packet.m_stencil_ref = index + 1;
+        submit(fill_pass, packet, depth);
+
+        if (m_selected_object_index == static_cast <i32> (index) and m_render_graph.is_active(m_highlight_pass)) {
+          const f32 scale_factor = 1.1f;
 
-          ++index;
+          packet.m_model = o->get_transform() * glm::scale(glm::mat4(1.0f), glm::vec3(scale_factor)) * o->get_mesh().get_dequantize();
+
+          packet.m_color = glm::vec4 {1.0f, 1.0f, 0.4f, 0.6f};
+          packet.m_use_vertex_color = false;
+          submit(m_highlight_pass, packet, depth);
         }
       }
 
-      scene.on_update(m_delta_time);
+      // Batches left empty this frame are dropped, so the meshes they point
+      // to are always alive
+      for (auto batch = m_instance_batches.begin(); batch != m_instance_batches.end();) {
+        auto &[key, instances] = *batch;
+
+        if (instances.get_instance_count() == 0) {
+          batch = m_instance_batches.erase(batch);
+          continue;
+        }
+
+        const auto &[mesh, lod_index, pass] = key;
+        const mesh_allocation &allocation = mesh->get_allocation();
+        const mesh_lod &lod = mesh->get_lods()[lod_index];
+
+        instances.upload(mesh->get_buffer());
+
+        submit(pass, {
+          0, &m_instanced_draw_program,
+          &instances.get_vertex_array(), &mesh->get_index_buffer(),
+          allocation.m_first_index + lod.m_index_offset, lod.m_index_count, allocation.m_base_vertex,
+          glm::mat4(1.0f), 1.0f, glm::vec4 {0, 0, 0, 1}, true, {0, 0}, 0, instances.get_instance_count()
+        }, 0.0f);
+
+        instances.clear();
+        ++batch;
+      }
+    }
+    else {
+      m_simulation.stop();
+      m_visible_count = 0;
+      m_culled_count = 0;
+    }
+
+    m_profiler.end_cpu();
+
+    {
+      PROFILE_SCOPE(m_profiler, "Sort");
+      m_render_queue.sort();
+    }
+
+    {
+      PROFILE_SCOPE(m_profiler, "Draw");
+
+      m_profiler.begin_gpu("Draw");
+      m_palettes.bind(palette_texture_unit);
+      draw_queue(m_render_queue, &m_profiler);
+      m_profiler.end_gpu();
     }
 
-    imgui_update();
+    if (not m_headless)
+      imgui_update();
 
     m_running = !glfwWindowShouldClose(m_window);
   }
@@ -414,6 +735,8 @@ namespace gl {
   }
 
   void application::imgui_update () {
+    PROFILE_SCOPE(m_profiler, "ImGui");
+
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
@@ -444,8 +767,28 @@ namespace gl {
         if (m_scene_index >= 0 and m_scene_index < (i32)m_scenes.size()) {
           auto &scene = *m_scenes[m_scene_index];
 
-          for (auto &o: scene.get_objects())
+          const auto &objects = scene.get_objects();
+
+          for (u32 i = 0; i < objects.size() and i < max_listed_objects; ++i) {
+            auto &o = objects[i];
+
+            // Names need not be unique, the index tells the checkboxes apart
+            ImGui::PushID(static_cast <i32> (i));
             ImGui::Checkbox(o->get_name().c_str(), &o->m_should_render);
+            ImGui::PopID();
+
+            if (!o->is_resident()) {
+              ImGui::SameLine();
+              ImGui::TextDisabled("(loading)");
+            }
+            else if (o->get_lods().size() > 1) {
+              ImGui::SameLine();
+              ImGui::TextDisabled("LOD %u/%zu", o->get_lod_index(), o->get_lods().size() - 1);
+            }
+          }
+
+          if (objects.size() > max_listed_objects)
+            ImGui::TextDisabled("and %zu more", objects.size() - max_listed_objects);
         }
 
         ImGui::TreePop();
@@ -459,6 +802,13 @@ namespace gl {
         ImGui::Checkbox("Outline", &m_display_outline);
         ImGui::Checkbox("Wireframe", &m_display_wireframe);
         ImGui::Checkbox("Depth Test", &m_display_depth_test);
+        ImGui::SliderFloat("LOD Error (px)", &m_lod_threshold, 0.0f, 8.0f);
+
+        const char *broad_phases[] = { "Spatial hash", "Sweep and prune" };
+        i32 broad_phase = static_cast <i32> (m_simulation.get_broad_phase());
+
+        if (ImGui::Combo("Broad phase", &broad_phase, broad_phases, IM_ARRAYSIZE(broad_phases)))
+          m_simulation.set_broad_phase(static_cast <broad_phase_type> (broad_phase));
 
         ImGui::TreePop();
       }
@@ -483,12 +833,55 @@ namespace gl {
 
     ImGui::Text("Last render %.3f ms", m_delta_time * 1000);
     ImGui::Text("FPS %.3f", ImGui::GetIO().Framerate);
+
+    if (u32 pending = m_asset_streamer.get_pending_count(); pending > 0)
+      ImGui::Text("Streaming %u meshes", pending);
+
+    ImGui::Text("Mesh assets in GPU memory %u", m_mesh_registry.get_mesh_count());
+
+    if (m_simulation.get_scene() != nullptr) {
+      ImGui::Text(
+        "Simulation tick %llu at %.0f Hz, %.3f ms per tick",
+        static_cast <unsigned long long> (m_simulation.get_tick()), m_simulation.get_tick_rate(), m_simulation.get_step_time()
+      );
+
+      auto collisions = m_simulation.get_collision_statistics();
+
+      ImGui::Text("Colliders %u, %u pairs, %u contacts", collisions.m_colliders, collisions.m_pairs, collisions.m_contacts);
+      ImGui::Text("Broad phase %.3f ms, response %.3f ms", collisions.m_broad_phase_time, collisions.m_response_time);
+    }
+
+    ImGui::Text("Objects visible %u, culled %u", m_visible_count, m_culled_count);
+
+    const auto &statistics = get_statistics();
+    ImGui::Text("Draw calls %u", statistics.m_draw_calls);
+    ImGui::Text("State changes %u issued, %u skipped", statistics.m_state_changes, statistics.m_redundant_changes);
+
+    if (ImGui::TreeNode("Profiler")) {
+      ImGui::Text("%-28s %9s %9s", "Scope", "avg ms", "max ms");
+
+      for (const auto &scope: m_profiler.get_scopes()) {
+        std::string name = std::string(2 * scope.m_depth, ' ') + (scope.m_gpu ? "GPU " : "CPU ") + scope.m_name;
+        ImGui::Text("%-28s %9.3f %9.3f", name.c_str(), scope.get_average(), scope.get_max());
+      }
+
+      if (m_profiler.is_capturing())
+        ImGui::TextDisabled("Capturing %u frames", trace_frames);
+      else
+        ImGui::TextDisabled("Press F2 to write %u frames to a trace", trace_frames);
+
+      ImGui::TreePop();
+    }
+
     ImGui::Text("Press ESC to exit");
 
     ImGui::End();
 
     ImGui::Render();
+
+    m_profiler.begin_gpu("ImGui");
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    m_profiler.end_gpu();
   }
 
   void application::keypress_update () {
@@ -497,6 +890,12 @@ namespace gl {
       return;
     }
 
+    if (m_key_pressed[GLFW_KEY_F2]) {
+      // chrome://tracing or https://ui.perfetto.dev open the file
+      m_profiler.capture(trace_frames, "trace-" + std::to_string(std::time(nullptr)) + ".json");
+      m_key_pressed[GLFW_KEY_F2] = false;
+    }
+
     if (m_key_pressed[GLFW_KEY_TAB]) {
       ++m_scene_index;
       m_scene_index %= m_scenes.size();
@@ -568,6 +967,30 @@ namespace gl {
     m_shader_program->add_shader(vertex_shader);
     m_shader_program->add_shader(fragment_shader);
     m_shader_program->link();
+
+    m_draw_program.m_program = m_shader_program.get();
+    m_draw_program.m_draw = m_shader_program->get_uniform <i32> ("u_draw");
+
+    // The renderer binds the per draw data to texture unit 0
+    m_shader_program->bind();
+    m_shader_program->set_uniform("u_draws", 0);
+    m_shader_program->set_uniform("u_palettes", static_cast <i32> (palette_texture_unit));
+
+    gl::shader instanced_vertex_shader (gl::shader_type::vertex, "../src/shaders/instanced.vertex.shader.glsl");
+
+    m_instanced_shader_program = std::make_unique <shader_program> ();
+    m_instanced_shader_program->add_shader(instanced_vertex_shader);
+    m_instanced_shader_program->add_shader(fragment_shader);
+    m_instanced_shader_program->link();
+
+    m_instanced_draw_program.m_program = m_instanced_shader_program.get();
+
+    m_instanced_shader_program->bind();
+    m_instanced_shader_program->set_uniform("u_palettes", static_cast <i32> (palette_texture_unit));
+
+    m_frame_uniforms = std::make_unique <uniform_buffer> (sizeof(frame_uniforms), frame_uniforms_binding);
+    m_shader_program->bind_uniform_block("frame", frame_uniforms_binding, sizeof(frame_uniforms), frame_uniforms_layout);
+    m_instanced_shader_program->bind_uniform_block("frame", frame_uniforms_binding, sizeof(frame_uniforms), frame_uniforms_layout);
   }
 
   void application::create_grid () {
@@ -602,18 +1025,76 @@ namespace gl {
     m_grid->load();
   }
 
+  // Picks the level of detail of every object from how large its bounding
+  // sphere is on screen
+  void application::select_lods (scene &scene) {
+    // Size in pixels of one world unit at distance one
+    f32 pixels_per_unit = m_height / (2.0f * glm::tan(glm::radians(m_camera.get_fov()) / 2.0f));
+
+    for (auto &o: scene.get_objects()) {
+      if (!o->is_resident() or o->get_lods().size() < 2)
+        continue;
+
+      glm::vec4 sphere = o->get_bounding_sphere();
+      f32 distance = glm::distance(glm::vec3(sphere), m_camera.get_position());
+
+      // From inside the sphere the object may cover the whole screen
+      f32 projected_radius = distance > sphere.w
+        ? sphere.w / distance * pixels_per_unit
+        : std::numeric_limits <f32>::infinity();
+
+      o->select_lod(projected_radius, m_lod_threshold);
+    }
+  }
+
+  // Objects that are hidden or still streaming in count as neither visible
+  // nor culled
+  void application::cull_objects (scene &scene, const glm::mat4 &view_projection) {
+    frustum view_frustum (view_projection);
+
+    const auto &objects = scene.get_objects();
+    u32 size = objects.size();
+    u32 blocks = (size + cull_block - 1) / cull_block;
+
+    m_culler.resize(size);
+
+    m_job_system.parallel_for(0, blocks, 1, [&] (u32 first, u32 last) {
+      u32 begin = first * cull_block;
+      u32 end = std::min(last * cull_block, size);
+
+      for (u32 i = begin; i < end; ++i) {
+        const object &o = *objects[i];
+
+        if (o.m_should_render and o.is_resident())
+          m_culler.set_sphere(i, o.get_tight_bounding_sphere());
+        else
+          m_culler.set_sphere(i, glm::vec4(0.0f, 0.0f, 0.0f, -1.0f));
+      }
+
+      m_culler.cull(view_frustum, begin, end);
+    });
+
+    u32 drawable = std::count_if(objects.begin(), objects.end(), [] (const auto &o) {
+      return o->m_should_render and o->is_resident();
+    });
+
+    m_visible_count = m_culler.get_visible_count();
+    m_culled_count = drawable - m_visible_count;
+  }
+
   void application::initialise_demo () {
     m_scenes.emplace_back(create_scene_none());
     m_scenes.emplace_back(create_scene_triangle(m_width, m_height, m_depth));
     m_scenes.emplace_back(create_scene_rectangle(m_width, m_height, m_depth));
     m_scenes.emplace_back(create_scene_cuboid(m_width, m_height, m_depth));
     m_scenes.emplace_back(create_scene_circle(m_width, m_height, m_depth));
-    m_scenes.emplace_back(create_scene_sphere(m_width, m_height, m_depth));
-    m_scenes.emplace_back(create_scene_torus(m_width, m_height, m_depth));
-    m_scenes.emplace_back(create_scene_suzanne(m_width, m_height, m_depth));
-    m_scenes.emplace_back(create_scene_klein_bottle(m_width, m_height, m_depth));
-    m_scenes.emplace_back(create_scene_planetary_gear(m_width, m_height, m_depth));
-    m_scenes.emplace_back(create_scene_assignment(m_width, m_height, m_depth));
+    m_scenes.emplace_back(create_scene_sphere(m_asset_streamer, m_mesh_registry, m_palettes, m_width, m_height, m_depth));
+    m_scenes.emplace_back(create_scene_torus(m_asset_streamer, m_mesh_registry, m_palettes, m_width, m_height, m_depth));
+    m_scenes.emplace_back(create_scene_suzanne(m_asset_streamer, m_mesh_registry, m_palettes, m_width, m_height, m_depth));
+    m_scenes.emplace_back(create_scene_klein_bottle(m_asset_streamer, m_mesh_registry, m_palettes, m_width, m_height, m_depth));
+    m_scenes.emplace_back(create_scene_planetary_gear(m_asset_streamer, m_mesh_registry, m_palettes, m_width, m_height, m_depth));
+    m_scenes.emplace_back(create_scene_assignment(m_asset_streamer, m_mesh_registry, m_palettes, m_width, m_height, m_depth));
+    m_scenes.emplace_back(create_scene_stress(m_asset_streamer, m_mesh_registry, m_palettes, m_width, m_height, m_depth, stress_object_count));
   }
 
   static std::unique_ptr <gl::scene> create_scene_none () {
@@ -744,7 +1225,7 @@ namespace gl {
     return scene;
   }
 
-  static std::unique_ptr <gl::scene> create_scene_sphere (u32 width, u32 height, u32 depth) {
+  static std::unique_ptr <gl::scene> create_scene_sphere (asset_streamer &streamer, mesh_registry &meshes, palette_buffer &palettes, u32 width, u32 height, u32 depth) {
     f32 w_mid = (f32)width / 2;
     f32 h_mid = (f32)height / 2;
     f32 d_mid = (f32)depth / 2;
@@ -758,19 +1239,18 @@ namespace gl {
     };
 
     auto scene = std::make_unique <gl::scene> ("Sphere", scene_properties());
-    auto object = load_blender_obj("../res/sphere.obj", "Sphere", colors);
+    auto object = load_blender_obj(streamer, meshes, palettes, "../res/sphere.obj", "Sphere", colors);
 
     (*object)
       .scale(glm::vec3(100.0f))
       .translate({w_mid, h_mid, -d_mid});
 
-    object->load();
     scene->add_object(std::move(object));
     
     return scene;
   }
 
-  static std::unique_ptr <gl::scene> create_scene_torus (u32 width, u32 height, u32 depth) {
+  static std::unique_ptr <gl::scene> create_scene_torus (asset_streamer &streamer, mesh_registry &meshes, palette_buffer &palettes, u32 width, u32 height, u32 depth) {
     f32 w_mid = (f32)width / 2;
     f32 h_mid = (f32)height / 2;
     f32 d_mid = (f32)depth / 2;
@@ -784,47 +1264,48 @@ namespace gl {
     }
 
     auto scene = std::make_unique <gl::scene> ("Torus", scene_properties());
-    auto object = load_blender_obj("../res/torus.obj", "Torus", colors);
+    auto object = load_blender_obj(streamer, meshes, palettes, "../res/torus.obj", "Torus", colors);
 
     (*object)
       .scale(glm::vec3(100.0f))
       .rotate(90.f, {1, 0, 0})
       .translate({w_mid, h_mid, -d_mid});
 
-    object->load();
     scene->add_object(std::move(object));
     
     return scene;
   }
 
-  static std::unique_ptr <gl::scene> create_scene_suzanne (u32 width, u32 height, u32 depth) {
+  static std::unique_ptr <gl::scene> create_scene_suzanne (asset_streamer &streamer, mesh_registry &meshes, palette_buffer &palettes, u32 width, u32 height, u32 depth) {
     f32 w_mid = (f32)width / 2;
     f32 h_mid = (f32)height / 2;
     f32 d_mid = (f32)depth / 2;
 
     std::vector <glm::vec3> colors;
 
+    // A fixed seed keeps the palette the same from one launch to the next
+    std::mt19937 palette_mt (256);
+
     for (i32 i = 0; i < 256; ++i) {
-      glm::vec3 color (rng(mt), rng(mt), rng(mt));
+      glm::vec3 color (rng(palette_mt), rng(palette_mt), rng(palette_mt));
       color += 1.0f;
       color /= 2.0f;
       colors.push_back(color);
     }
 
     auto scene = std::make_unique <gl::scene> ("Suzanne", scene_properties());
-    auto object = load_blender_obj("../res/suzanne.obj", "Suzanne", colors);
+    auto object = load_blender_obj(streamer, meshes, palettes, "../res/suzanne.obj", "Suzanne", colors);
     
     (*object)
       .scale(glm::vec3(100.0f))
       .translate({w_mid, h_mid, -d_mid});
 
-    object->load();
     scene->add_object(std::move(object));
     
     return scene;
   }
 
-  static std::unique_ptr <gl::scene> create_scene_klein_bottle (u32 width, u32 height, u32 depth) {
+  static std::unique_ptr <gl::scene> create_scene_klein_bottle (asset_streamer &streamer, mesh_registry &meshes, palette_buffer &palettes, u32 width, u32 height, u32 depth) {
     f32 w_mid = (f32)width / 2;
     f32 h_mid = (f32)height / 2;
     f32 d_mid = (f32)depth / 2;
@@ -838,20 +1319,19 @@ namespace gl {
     }
 
     auto scene = std::make_unique <gl::scene> ("Klein Bottle", scene_properties());
-    auto object = load_blender_obj("../res/klein-bottle.obj", "Klein Bottle", colors);
+    auto object = load_blender_obj(streamer, meshes, palettes, "../res/klein-bottle.obj", "Klein Bottle", colors);
     
     (*object)
       .scale(glm::vec3(100.0f))
       .translate({w_mid, h_mid, -d_mid})
       .set_blend(0.5f);
 
-    object->load();
     scene->add_object(std::move(object));
     
     return scene;
   }
 
-  static std::unique_ptr <gl::scene> create_scene_planetary_gear (u32 width, u32 height, u32 depth) {
+  static std::unique_ptr <gl::scene> create_scene_planetary_gear (asset_streamer &streamer, mesh_registry &meshes, palette_buffer &palettes, u32 width, u32 height, u32 depth) {
     f32 w_mid = (f32)width / 2;
     f32 h_mid = (f32)height / 2;
     f32 d_mid = (f32)depth / 2;
@@ -866,7 +1346,7 @@ namespace gl {
 
     auto scene = std::make_unique <gl::scene> ("Planetary Gear", scene_properties());
 
-    auto object = load_blender_obj("../res/planetary-gear.obj", "Planetary Gear", colors);
+    auto object = load_blender_obj(streamer, meshes, palettes, "../res/planetary-gear.obj", "Planetary Gear", colors);
 
     (*object)
       .scale(glm::vec3(2.0f))
@@ -874,13 +1354,12 @@ namespace gl {
       .set_rotation_angles(glm::vec3(0.2f))
       .translate({w_mid, h_mid, -d_mid});
 
-    object->load();
     scene->add_object(std::move(object));
     
     return scene;
   }
 
-  static std::unique_ptr <gl::scene> create_scene_assignment (u32 width, u32 height, u32 depth) {
+  static std::unique_ptr <gl::scene> create_scene_assignment (asset_streamer &streamer, mesh_registry &meshes, palette_buffer &palettes, u32 width, u32 height, u32 depth) {
     f32 w_mid = (f32)width / 2;
     f32 h_mid = (f32)height / 2;
     f32 d_mid = (f32)depth / 2;
@@ -944,16 +1423,17 @@ namespace gl {
       colors3.push_back(color);
     }
 
-    auto object1 = load_blender_obj("../res/sphere.obj", "Sphere", colors1);
-    auto object2 = load_blender_obj("../res/klein-bottle.obj", "Klein Bottle", colors2);
-    auto object3 = load_blender_obj("../res/planetary-gear.obj", "Planetary Gear", colors3);
+    auto object1 = load_blender_obj(streamer, meshes, palettes, "../res/sphere.obj", "Sphere", colors1);
+    auto object2 = load_blender_obj(streamer, meshes, palettes, "../res/klein-bottle.obj", "Klein Bottle", colors2);
+    auto object3 = load_blender_obj(streamer, meshes, palettes, "../res/planetary-gear.obj", "Planetary Gear", colors3);
 
+    // The container, the other two move inside it
     (*object1)
       .scale(glm::vec3(sphere_radius) + 100.0f)
       .translate({w_mid, h_mid, -d_mid})
       .set_rotation_angles(random_rotation_angles())
       .set_blend(0.05f)
-      .load();
+      .set_collision(false);
 
     (*object2)
       .scale(glm::vec3(15.0f))
@@ -961,8 +1441,7 @@ namespace gl {
       .translate({w_mid, h_mid, -d_mid})
       .set_velocity(random_velocity())
       .set_rotation_angles(random_rotation_angles())
-      .set_blend(0.4f)
-      .load();
+      .set_blend(0.4f);
 
     (*object3)
       .scale(glm::vec3(0.5f))
@@ -970,8 +1449,7 @@ namespace gl {
       .translate(random_point_inside_sphere())
       .translate({w_mid, h_mid, -d_mid})
       .set_velocity(random_velocity())
-      .set_rotation_angles(random_rotation_angles())
-      .load();
+      .set_rotation_angles(random_rotation_angles());
     
     scene->add_object(std::move(object3));
     scene->add_object(std::move(object2));
@@ -980,6 +1458,47 @@ namespace gl {
     return scene;
   }
 
+  static std::unique_ptr <gl::scene> create_scene_stress (asset_streamer &streamer, mesh_registry &meshes, palette_buffer &palettes, u32 width, u32 height, u32 depth, u32 count) {
+    f32 w_mid = (f32)width / 2;
+    f32 h_mid = (f32)height / 2;
+    f32 d_mid = (f32)depth / 2;
+
+    const f32 extent = 400.0f;
+    const f32 velocity_factor = 50.0f;
+
+    static std::vector <glm::vec3> colors = {
+      {0.2f, 0.4f, 0.8f},
+      {0.2f, 0.5f, 0.8f},
+      {0.2f, 0.6f, 0.9f},
+      {0.3f, 0.7f, 1.0f}
+    };
+
+    auto scene = std::make_unique <gl::scene> (
+      "Stress",
+      scene_properties(
+        w_mid - extent, w_mid + extent,
+        h_mid + extent, h_mid - extent,
+        -d_mid + extent, -d_mid - extent
+      )
+    );
+
+    // Every sphere shares the one mesh, so they end up in a few instanced
+    // draws
+    for (u32 i = 0; i < count; ++i) {
+      auto object = load_blender_obj(streamer, meshes, palettes, "../res/sphere.obj", "Sphere", colors);
+
+      (*object)
+        .scale(glm::vec3(3.0f))
+        .translate(glm::vec3(rng(mt), rng(mt), rng(mt)) * extent)
+        .translate({w_mid, h_mid, -d_mid})
+        .set_velocity(glm::vec3(rng(mt), rng(mt), rng(mt)) * velocity_factor);
+
+      scene->add_object(std::move(object));
+    }
+
+    return scene;
+  }
+
   glm::vec3 rotate_point (glm::vec3 center, glm::vec3 point, f32 angle) {
     f32 s = glm::sin(angle);
     f32 c = glm::cos(angle);
@@ -1024,54 +1543,146 @@ namespace gl {
       .translate({w_mid, h_mid, -d_mid});
   }
 
+  // The packet drawing an object's selected level of detail with its vertex
+  // colors, the pass is set when it is submitted
+  draw_packet object_packet (const draw_program &program, const object &o) {
+    const mesh_allocation &allocation = o.get_mesh().get_allocation();
+
+    return {
+      0, &program,
+      &o.get_vertex_array(), &o.get_index_buffer(),
+      allocation.m_first_index + o.get_lod().m_index_offset, o.get_lod().m_index_count, allocation.m_base_vertex,
+      o.get_model(), o.get_blend(), glm::vec4 {0, 0, 0, 1}, true, o.get_palette(), 0, 0
+    };
+  }
+
+  // Returns the object right away. Its mesh is shared with the objects
+  // already drawing the same file, whatever their colors, otherwise it is
+  // streamed in by the asset streamer and the object is drawn once it is
+  // resident. The colors are the object's palette
   std::unique_ptr <gl::object> load_blender_obj (
+    asset_streamer &streamer, mesh_registry &meshes, palette_buffer &palettes,
     const std::string &filepath, const std::string &name,
     const std::vector <glm::vec3>& colors
   ) {
-    std::ifstream file (filepath);
-    std::string line;
-    std::stringstream stream;
+    u64 key = hash_bytes(filepath.data(), filepath.size(), hash_bytes(&mesh_vertex_format, sizeof(mesh_vertex_format)));
+    auto mesh = meshes.find(key);
 
-    auto object = std::make_unique <gl::object> (name.c_str());
-    u32 size = colors.size();
+    if (not mesh) {
+      mesh = meshes.create(key, mesh_vertex_format);
+      stream_mesh(streamer, mesh, filepath);
+    }
 
-    while (not file.eof()) {
-      std::getline(file, line);
-      
-      if (line.starts_with("v ")) {
-        stream << line.substr(2);
-        
-        glm::vec3 v;
-        stream >> v.x >> v.y >> v.z;
-        
-        object->add_vertex(v, colors[std::floor((rng(mt) + 1) * size / 2)]);
+    auto object = std::make_unique <gl::object> (name, std::move(mesh));
+    object->set_palette(palettes.add(colors));
+
+    return object;
+  }
+
+  // Parameters are taken by value, the coroutine outlives its caller and
+  // keeps the mesh alive until it is loaded
+  task stream_mesh (asset_streamer &streamer, std::shared_ptr <gpu_mesh> target, std::string filepath) {
+    blender_mesh mesh = co_await load_mesh(streamer, filepath, target->get_vertex_format());
+
+    // Back on the GL thread, the cache is unmapped once it is uploaded
+    (*target)
+      .set_bounds(mesh.m_bounds)
+      .set_bounding_sphere(mesh.m_bounding_sphere)
+      .load(
+        mesh.get_vertex_data(), mesh.get_vertex_size(),
+        mesh.get_index_data(), mesh.get_index_count()
+      )
+      .set_lods(mesh.m_lods);
+  }
+
+  async_result <blender_mesh> load_mesh (asset_streamer &streamer, const std::string &filepath, vertex_format format) {
+    return streamer.run([&jobs = streamer.get_job_system(), filepath, format] () {
+      blender_mesh result;
+
+      // The format is baked into the cache, so it is part of what the cache
+      // is validated against
+      u64 key = hash_bytes(&format, sizeof(format));
+      u32 stride = get_vertex_layout(format).get_stride();
+      mesh_cache cache;
+
+      if (cache.open(filepath, stride, key)) {
+        result.m_lods = cache.get_lods();
+        result.m_bounds = cache.get_bounds();
+        result.m_bounding_sphere = cache.get_bounding_sphere();
+        result.m_cache = std::move(cache);
+        return result;
       }
-      else if (line.starts_with("f ")) {
-        i32 x, y, z;
 
-        stream << line.substr(2);
-        
-        stream >> line;
-        x = std::stoi(line.substr(0, line.find_first_of('/'))) - 1;
+      obj_mesh mesh;
 
-        stream >> line;
-        y = std::stoi(line.substr(0, line.find_first_of('/'))) - 1;
+      if (not load_obj(filepath, mesh, obj_attribute::position, &jobs))
+        return result;
 
-        stream >> line;
-        z = std::stoi(line.substr(0, line.find_first_of('/'))) - 1;
+      // Only pays off once, the cache keeps the optimized order
+      optimize_mesh(mesh);
+      result.m_lods = build_lod_chain(mesh.m_indices, mesh.m_positions);
 
-        (*object)
-          .add_index(x)
-          .add_index(y)
-          .add_index(z);
-      }
+      // Every vertex gets a random palette index, see palette_buffer.
+      // Seeded from the key so a rebuilt cache picks the same ones
+      std::mt19937 color_rng (key);
+      std::uniform_int_distribution <u32> color_index (0, palette_buffer::max_palette_size - 1);
 
-      stream.clear();
+      result.m_bounds = compute_bounds(mesh.m_positions);
+      result.m_bounding_sphere = compute_bounding_sphere(mesh.m_positions, result.m_bounds);
+
+      vertex_encoder encoder (format, result.m_bounds);
+      result.m_vertices.resize(mesh.m_positions.size() * stride);
+
+      for (u64 i = 0; i < mesh.m_positions.size(); ++i)
+        encoder.encode(mesh.m_positions[i], glm::vec3(color_index(color_rng) / 255.0f), &result.m_vertices[i * stride]);
+
+      result.m_indices = std::move(mesh.m_indices);
+
+      mesh_cache::write(
+        filepath, key,
+        result.m_vertices.data(), stride, mesh.m_positions.size(),
+        result.m_indices.data(), result.m_indices.size(),
+        result.m_bounds, result.m_bounding_sphere, result.m_lods
+      );
+
+      return result;
+    });
+  }
+
+  const void* blender_mesh::get_vertex_data () const {
+    return m_cache.is_open() ? m_cache.get_vertex_data() : m_vertices.data();
+  }
+
+  u32 blender_mesh::get_vertex_size () const {
+    if (not m_cache.is_open())
+      return m_vertices.size();
+
+    return m_cache.get_vertex_count() * m_cache.get_vertex_stride();
+  }
+
+  const u32* blender_mesh::get_index_data () const {
+    return m_cache.is_open() ? m_cache.get_index_data() : m_indices.data();
+  }
+
+  u32 blender_mesh::get_index_count () const {
+    return m_cache.is_open() ? m_cache.get_index_count() : m_indices.size();
+  }
+
+  // Binary PPM (P6), which every image viewer and converter reads
+  bool write_ppm (const std::string &path, const framebuffer &target) {
+    std::ofstream file (path, std::ios::binary);
+
+    if (not file) {
+      std::cerr << "Failed to write image " << path << std::endl;
+      return false;
     }
 
-    file.close();
+    std::vector <byte> pixels = target.read_pixels();
 
-    return object;
+    file << "P6\n" << target.get_width() << " " << target.get_height() << "\n255\n";
+    file.write(reinterpret_cast <const char*> (pixels.data()), pixels.size());
+
+    return true;
   }
 
 } // namespace gl
@@ -3,16 +3,29 @@
 
 #include <string>
 #include <functional>
+#include <map>
 #include <memory>
+#include <tuple>
+#include <unordered_map>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 #include "types.hpp"
 #include "renderer.hpp"
+#include "instance_batch.hpp"
+#include "render_graph.hpp"
+#include "profiler.hpp"
+#include "frustum.hpp"
+#include "shader/uniform_buffer.hpp"
+#include "shader/palette_buffer.hpp"
+#include "job/job_system.hpp"
 #include "scene.hpp"
+#include "simulation.hpp"
 #include "object.hpp"
 #include "camera.hpp"
+#include "asset/asset_streamer.hpp"
+#include "asset/mesh_registry.hpp"
 
 namespace gl {
 
@@ -27,7 +40,19 @@ namespace gl {
       GLFWwindow* m_window;
       bool m_running;
 
+      // Renders into a hidden window's context without ImGui, at a fixed
+      // time step, see run_headless
+      bool m_headless;
+
       std::unique_ptr <shader_program> m_shader_program;
+      std::unique_ptr <uniform_buffer> m_frame_uniforms;
+
+      // m_shader_program and its uniforms, resolved once it is linked
+      draw_program m_draw_program;
+
+      // Reads its per draw data from instance attributes, see instance_batch
+      std::unique_ptr <shader_program> m_instanced_shader_program;
+      draw_program m_instanced_draw_program;
 
       camera m_camera;
       f32 m_delta_time;
@@ -48,9 +73,51 @@ namespace gl {
       bool m_display_depth_test;
       bool m_display_smooth_lines;
 
+      // Largest screen space error, in pixels, a level of detail may have
+      f32 m_lod_threshold;
+
+      // Every draw of a frame goes through the queue. Its passes are those
+      // of the graph still active, in the order below, see render_graph
+      render_queue m_render_queue;
+      render_graph m_render_graph;
+      u32 m_grid_pass;
+      u32 m_wireframe_pass;
+      u32 m_outline_pass;
+      u32 m_opaque_pass;
+      u32 m_blended_pass;
+      u32 m_highlight_pass;
+
+      // Objects sharing a mesh with at least m_min_instances others are drawn
+      // with one instanced draw per (mesh, level of detail, pass), and can
+      // not be picked
+      static constexpr u32 m_min_instances = 16;
+      using instance_key = std::tuple <const gpu_mesh*, u32, u32>;
+      std::map <instance_key, instance_batch> m_instance_batches;
+      std::unordered_map <const gpu_mesh*, u32> m_mesh_users;
+
       // 348 is the maximum value of a GLFW_KEY_<XXXX>
       static constexpr u32 m_key_count = 349;
       std::vector <bool> m_key_pressed;
+
+      // Work split across every hardware thread, the GL thread included
+      job_system m_job_system;
+
+      // Scene meshes are parsed on its workers and uploaded by on_update
+      asset_streamer m_asset_streamer;
+
+      // Meshes shared by the objects of every scene, and the palettes the
+      // objects color them with
+      mesh_registry m_mesh_registry;
+      palette_buffer m_palettes;
+
+      // CPU and GPU time of the parts of every frame, F2 writes a trace
+      profiler m_profiler;
+
+      // Which objects of the current scene are in view, by their index in
+      // it. Redone every frame before anything is submitted
+      frustum_culler m_culler;
+      u32 m_visible_count;
+      u32 m_culled_count;
     
     public:
       std::vector <std::unique_ptr <scene>> m_scenes;
@@ -59,14 +126,24 @@ namespace gl {
       glm::vec3 m_cached_velocity;
       glm::vec3 m_cached_rotation_angles;
 
+    private:
+      // Moves the objects of the current scene on a thread of its own. After
+      // m_scenes, so it stops before they are destroyed
+      simulation m_simulation;
+
     public:
-      application (u32, u32, u32, const std::string&);
+      application (u32, u32, u32, const std::string&, bool = false);
       ~application ();
 
       void clear () const;
 
       void run ();
 
+      // Renders every scene for `frames` frames into an offscreen framebuffer
+      // and prints their frame times. When a directory is given, the last
+      // frame of every scene is written to it as a PPM image
+      void run_headless (u32, const std::string&);
+
       void on_resize (i32, i32);
       void on_keypress (i32, i32, i32, i32);
       void on_mouseclick (i32, i32, i32);
@@ -86,6 +163,8 @@ namespace gl {
       void set_shaders ();
 
       void create_grid ();
+      void select_lods (scene&);
+      void cull_objects (scene&, const glm::mat4&);
     
     public:
       void initialise_demo ();
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "types.hpp"
+#include "job/job_system.hpp"
+
+using namespace gl::types;
+
+template <typename F>
+static f64 best_of (u32 iterations, F &&f) {
+  f64 best = 1e30;
+
+  for (u32 i = 0; i < iterations; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration <f64> (stop - start).count());
+  }
+
+  return best;
+}
+
+// Work the compiler can not drop, about `units` times a few nanoseconds
+static f32 busy_work (u32 units) {
+  f32 x = 1.0f;
+
+  for (u32 i = 0; i < units; ++i)
+    x = std::sqrt(x + static_cast <f32> (i));
+
+  return x;
+}
+
+// The thread counts measured: 1, 2, 4, ... and every hardware thread
+static std::vector <u32> thread_counts (u32 hardware_threads) {
+  std::vector <u32> counts;
+
+  for (u32 count = 1; count < hardware_threads; count *= 2)
+    counts.push_back(count);
+
+  counts.push_back(hardware_threads);
+  return counts;
+}
+
+int main (int argc, char **argv) {
+  u32 iterations = argc > 1 ? std::stoul(argv[1]) : 10;
+  u32 job_count = argc > 2 ? std::stoul(argv[2]) : 1'000'000;
+  u32 hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  std::printf("%u hardware threads, best of %u\n", hardware_threads, iterations);
+
+  // What a job costs by itself: spawning, queueing, stealing and finishing
+  // empty jobs, all spawned by the main thread and then waited on. With one
+  // thread nothing is stolen, so that column is the bare bookkeeping
+  std::printf(
+    "\n%-8s %14s %14s %16s\n",
+    "threads", "spawn ns/job", "for ns/range", "std::thread ns"
+  );
+
+  for (u32 threads: thread_counts(hardware_threads)) {
+    gl::job_system jobs (threads);
+
+    f64 spawn = best_of(iterations, [&] {
+      gl::job_counter counter;
+
+      for (u32 i = 0; i < job_count; ++i)
+        jobs.spawn([] {}, &counter);
+
+      jobs.wait(counter);
+    });
+
+    f64 split = best_of(iterations, [&] {
+      jobs.parallel_for(0, job_count, 1, [] (u32, u32) {});
+    });
+
+    // For scale: a thread started and joined per job
+    u32 thread_jobs = std::min(job_count, 1000u);
+
+    f64 thread = best_of(iterations, [&] {
+      for (u32 i = 0; i < thread_jobs; ++i)
+        std::thread([] {}).join();
+    });
+
+    std::printf(
+      "%-8u %14.1f %14.1f %16.1f\n",
+      threads, spawn / job_count * 1e9, split / job_count * 1e9, thread / thread_jobs * 1e9
+    );
+  }
+
+  // Load balance: parallel_for over items whose cost is uniform, grows
+  // linearly with the index, or is concentrated in one item of every 64.
+  // Efficiency is the speedup over one thread divided by the thread count;
+  // share is the fewest and most ranges one thread ran, as a fraction of an
+  // even split
+  struct workload {
+    const char *m_name;
+    u32 (*m_cost) (u32);
+  };
+
+  static constexpr u32 item_count = 1 << 16;
+
+  const workload workloads[] = {
+    {"uniform", [] (u32) { return 64u; }},
+    {"linear", [] (u32 i) { return 1u + 128u * i / item_count; }},
+    {"spiky", [] (u32 i) { return i % 64 == 0 ? 4096u : 1u; }}
+  };
+
+  std::printf(
+    "\n%-10s %-8s %10s %10s %11s %10s %12s\n",
+    "workload", "threads", "ms", "speedup", "efficiency", "steals", "share"
+  );
+
+  for (const auto &w: workloads) {
+    f64 single = 0.0;
+
+    for (u32 threads: thread_counts(hardware_threads)) {
+      gl::job_system jobs (threads);
+      std::atomic <f32> sink = 0.0f;
+
+      auto run = [&] {
+        jobs.parallel_for(0, item_count, 64, [&] (u32 first, u32 last) {
+          f32 sum = 0.0f;
+
+          for (u32 i = first; i < last; ++i)
+            sum += busy_work(w.m_cost(i));
+
+          sink = sink + sum;
+        });
+      };
+
+      f64 time = best_of(iterations, run);
+
+      // One more run for the statistics, on their own
+      jobs.reset_statistics();
+      run();
+
+      u64 steals = 0;
+      u64 fewest = ~0ull;
+      u64 most = 0;
+      u64 total = 0;
+
+      for (const auto &statistics: jobs.get_statistics()) {
+        steals += statistics.m_stolen;
+        total += statistics.m_executed;
+        fewest = std::min(fewest, statistics.m_executed);
+        most = std::max(most, statistics.m_executed);
+      }
+
+      // Only the ranges that were spawned count, the last one of every split
+      // runs inline
+      f64 even = std::max <f64> (1.0, static_cast <f64> (total) / threads);
+
+      if (threads == 1)
+        single = time;
+
+      std::printf(
+        "%-10s %-8u %10.3f %9.2fx %10.0f%% %10llu %5.2f..%-5.2f\n",
+        w.m_name, threads, time * 1e3, single / time, 100.0 * single / time / threads,
+        static_cast <unsigned long long> (steals), fewest / even, most / even
+      );
+    }
+  }
+
+  return 0;
+}
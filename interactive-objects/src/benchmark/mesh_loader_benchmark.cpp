@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "types.hpp"
+#include "mesh/obj_loader.hpp"
+#include "mesh/mesh_optimizer.hpp"
+#include "job/job_system.hpp"
+
+using namespace gl::types;
+
+// The loader that used to live in application.cpp, kept here so the numbers
+// always have a baseline to compare against
+static void load_obj_legacy (const std::string &filepath, gl::obj_mesh &mesh) {
+  std::ifstream file (filepath);
+  std::string line;
+  std::stringstream stream;
+
+  mesh.clear();
+
+  while (std::getline(file, line)) {
+    if (line.starts_with("v ")) {
+      stream << line.substr(2);
+
+      glm::vec3 v;
+      stream >> v.x >> v.y >> v.z;
+      mesh.m_positions.push_back(v);
+    }
+    else if (line.starts_with("f ")) {
+      stream << line.substr(2);
+
+      for (i32 i = 0; i < 3; ++i) {
+        stream >> line;
+        mesh.m_indices.push_back(std::stoi(line.substr(0, line.find_first_of('/'))) - 1);
+      }
+    }
+
+    stream.clear();
+  }
+}
+
+template <typename F>
+static f64 best_of (u32 iterations, F &&f) {
+  f64 best = 1e30;
+
+  for (u32 i = 0; i < iterations; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration <f64> (stop - start).count());
+  }
+
+  return best;
+}
+
+// Writes a regular grid mesh of roughly `megabytes` MB in the same shape as a
+// blender export (v records followed by v//vn faces)
+static std::filesystem::path write_synthetic_obj (u32 megabytes) {
+  auto path = std::filesystem::temp_directory_path() / "mesh-loader-benchmark-synthetic.obj";
+  std::FILE *file = std::fopen(path.c_str(), "w");
+
+  // ~36 bytes per vertex line and ~2 * 30 bytes of faces per vertex
+  u32 side = std::sqrt(megabytes * 1024.0 * 1024.0 / 96.0) + 2;
+
+  for (u32 z = 0; z < side; ++z)
+    for (u32 x = 0; x < side; ++x)
+      std::fprintf(file, "v %f %f %f\n", x * 0.01f, std::sin(x * 0.1f) * std::cos(z * 0.1f), z * 0.01f);
+
+  for (u32 z = 0; z + 1 < side; ++z) {
+    for (u32 x = 0; x + 1 < side; ++x) {
+      u32 a = z * side + x + 1;
+      u32 b = a + 1;
+      u32 c = a + side;
+      u32 d = c + 1;
+      std::fprintf(file, "f %u//1 %u//1 %u//1\nf %u//1 %u//1 %u//1\n", a, b, d, d, c, a);
+    }
+  }
+
+  std::fclose(file);
+
+  return path;
+}
+
+// Compares the triangles two meshes describe, regardless of vertex order
+static bool same_triangles (const gl::obj_mesh &a, const gl::obj_mesh &b) {
+  if (a.m_indices.size() != b.m_indices.size())
+    return false;
+
+  for (u64 i = 0; i < a.m_indices.size(); ++i)
+    if (std::memcmp(&a.m_positions[a.m_indices[i]], &b.m_positions[b.m_indices[i]], sizeof(glm::vec3)) != 0)
+      return false;
+
+  return true;
+}
+
+int main (int argc, char **argv) {
+  std::string directory = argc > 1 ? argv[1] : "../res";
+  u32 iterations = argc > 2 ? std::stoul(argv[2]) : 10;
+  u32 synthetic_size = argc > 3 ? std::stoul(argv[3]) : 0;
+  u32 threads = std::max(1u, std::thread::hardware_concurrency());
+  gl::job_system jobs (threads);
+
+  std::vector <std::filesystem::path> files;
+
+  for (auto &entry: std::filesystem::directory_iterator(directory))
+    if (entry.path().extension() == ".obj")
+      files.push_back(entry.path());
+
+  std::sort(files.begin(), files.end());
+
+  if (synthetic_size > 0)
+    files.push_back(write_synthetic_obj(synthetic_size));
+
+  std::printf("%u hardware threads\n", threads);
+  std::printf(
+    "%-36s %10s %10s %10s %14s %14s %8s %14s\n",
+    "file", "size (MB)", "vertices", "indices", "1 thread MB/s", "N thread MB/s", "scaling", "legacy MB/s"
+  );
+
+  for (auto &path: files) {
+    gl::obj_mesh mesh;
+    gl::obj_mesh threaded_mesh;
+    gl::obj_mesh legacy_mesh;
+
+    bool is_synthetic = path.parent_path() != std::filesystem::path(directory);
+    f64 size = std::filesystem::file_size(path) / (1024.0 * 1024.0);
+    f64 single = best_of(iterations, [&] { gl::load_obj(path.string(), mesh, gl::obj_attribute::position); });
+    f64 threaded = best_of(iterations, [&] { gl::load_obj(path.string(), threaded_mesh, gl::obj_attribute::position, &jobs); });
+
+    // the legacy loader is far too slow to be worth waiting on for the synthetic file
+    f64 legacy = is_synthetic ? 0.0 : best_of(iterations, [&] { load_obj_legacy(path.string(), legacy_mesh); });
+
+    if (mesh.m_indices != threaded_mesh.m_indices or
+        mesh.m_positions.size() != threaded_mesh.m_positions.size() or
+        std::memcmp(mesh.m_positions.data(), threaded_mesh.m_positions.data(), mesh.m_positions.size() * sizeof(glm::vec3)) != 0)
+      std::printf("warning: %s parsed differently with %u threads\n", path.filename().c_str(), threads);
+
+    if (not is_synthetic and not same_triangles(mesh, legacy_mesh))
+      std::printf("warning: %s parsed differently by the legacy loader\n", path.filename().c_str());
+
+    std::printf(
+      "%-36s %10.2f %10zu %10zu %14.1f %14.1f %7.2fx %14.1f\n",
+      path.filename().c_str(), size, mesh.m_positions.size(), mesh.m_indices.size(),
+      size / single, size / threaded, single / threaded, is_synthetic ? 0.0 : size / legacy
+    );
+  }
+
+  // Vertex counts without deduplication (one vertex per triangle corner)
+  // against one vertex per distinct position and per distinct v/vt/vn tuple.
+  // The saved bytes assume a float position, texcoord and normal per vertex
+  std::printf(
+    "\n%-36s %10s %10s %10s %12s %12s %12s\n",
+    "file", "indices", "corners", "positions", "v/vt/vn", "saved (KB)", "polygons"
+  );
+
+  for (auto &path: files) {
+    gl::obj_mesh positions;
+    gl::obj_mesh full;
+
+    gl::load_obj(path.string(), positions, gl::obj_attribute::position);
+    gl::load_obj(path.string(), full, gl::obj_attribute::all);
+
+    auto &statistics = full.m_statistics;
+    u64 vertex_size = sizeof(glm::vec3) + (full.m_texcoords.empty() ? 0 : sizeof(glm::vec2)) + (full.m_normals.empty() ? 0 : sizeof(glm::vec3));
+
+    std::printf(
+      "%-36s %10zu %10u %10u %12u %12.1f %12u\n",
+      path.filename().c_str(), full.m_indices.size(), statistics.m_corner_count,
+      positions.m_statistics.m_vertex_count, statistics.m_vertex_count,
+      (statistics.m_corner_count - statistics.m_vertex_count) * vertex_size / 1024.0, statistics.m_polygon_records
+    );
+
+    if (statistics.m_skipped_faces > 0)
+      std::printf("warning: %s has %u malformed faces\n", path.filename().c_str(), statistics.m_skipped_faces);
+  }
+
+  // Vertex cache efficiency of the meshes as the application draws them
+  // (positions only) in file order and after gl::optimize_mesh
+  std::printf(
+    "\n%-36s %10s %12s %12s %12s %12s %14s\n",
+    "file", "triangles", "ACMR before", "ACMR after", "ATVR before", "ATVR after", "optimize (ms)"
+  );
+
+  for (auto &path: files) {
+    gl::obj_mesh mesh;
+    gl::obj_mesh optimized;
+
+    gl::load_obj(path.string(), mesh);
+
+    f64 duration = best_of(iterations, [&] {
+      optimized = mesh;
+      gl::optimize_mesh(optimized);
+    });
+
+    auto before = gl::analyze_vertex_cache(mesh.m_indices, mesh.m_positions.size());
+    auto after = gl::analyze_vertex_cache(optimized.m_indices, optimized.m_positions.size());
+
+    std::printf(
+      "%-36s %10zu %12.3f %12.3f %12.3f %12.3f %14.2f\n",
+      path.filename().c_str(), mesh.m_indices.size() / 3,
+      before.m_acmr, after.m_acmr, before.m_atvr, after.m_atvr, duration * 1000.0
+    );
+
+    // The optimizer may only reorder triangles, never change them
+    auto triangles = [] (const gl::obj_mesh &m) {
+      std::vector <std::array <f32, 9>> result;
+
+      for (u64 i = 0; i < m.m_indices.size(); i += 3) {
+        std::array <f32, 9> triangle;
+
+        for (u32 c = 0; c < 3; ++c)
+          std::memcpy(&triangle[3 * c], &m.m_positions[m.m_indices[i + c]], sizeof(glm::vec3));
+
+        result.push_back(triangle);
+      }
+
+      std::sort(result.begin(), result.end());
+      return result;
+    };
+
+    if (triangles(mesh) != triangles(optimized))
+      std::printf("warning: %s has different triangles after optimization\n", path.filename().c_str());
+
+    if (path.parent_path() != std::filesystem::path(directory))
+      std::filesystem::remove(path);
+  }
+
+  return 0;
+}
@@ -0,0 +1,104 @@
+#include <algorithm>
+
+#include "asset_streamer.hpp"
+
+namespace gl {
+
+  asset_streamer::asset_streamer (job_system &jobs, u32 worker_count)
+    : m_job_system (jobs),
+      m_workers (),
+      m_jobs (),
+      m_jobs_mutex (),
+      m_jobs_available (),
+      m_stopping (false),
+      m_ready (),
+      m_ready_mutex (),
+      m_pending_count (0) {
+
+    if (worker_count == 0)
+      worker_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+    m_workers.reserve(worker_count);
+
+    for (u32 i = 0; i < worker_count; ++i)
+      m_workers.emplace_back(&asset_streamer::work, this);
+  }
+
+  asset_streamer::~asset_streamer () {
+    {
+      std::lock_guard lock (m_jobs_mutex);
+      m_stopping = true;
+    }
+
+    m_jobs_available.notify_all();
+
+    for (auto &worker: m_workers)
+      worker.join();
+
+    // Coroutines that will never be resumed still own their frames
+    for (auto &job: m_jobs)
+      job.m_handle.destroy();
+
+    for (auto handle: m_ready)
+      handle.destroy();
+  }
+
+  u32 asset_streamer::poll () {
+    std::vector <std::coroutine_handle <>> ready;
+
+    {
+      std::lock_guard lock (m_ready_mutex);
+      ready.swap(m_ready);
+    }
+
+    // A resumed coroutine may await again, which only queues a new job
+    for (auto handle: ready) {
+      --m_pending_count;
+      handle.resume();
+    }
+
+    return ready.size();
+  }
+
+  u32 asset_streamer::get_pending_count () const {
+    return m_pending_count.load();
+  }
+
+  job_system& asset_streamer::get_job_system () {
+    return m_job_system;
+  }
+
+  void asset_streamer::submit (std::function <void ()> &&work, std::coroutine_handle <> handle) {
+    ++m_pending_count;
+
+    {
+      std::lock_guard lock (m_jobs_mutex);
+      m_jobs.push_back({std::move(work), handle});
+    }
+
+    m_jobs_available.notify_one();
+  }
+
+  void asset_streamer::work () {
+    while (true) {
+      job next;
+
+      {
+        std::unique_lock lock (m_jobs_mutex);
+        m_jobs_available.wait(lock, [this] { return m_stopping or not m_jobs.empty(); });
+
+        if (m_stopping)
+          return;
+
+        next = std::move(m_jobs.front());
+        m_jobs.pop_front();
+      }
+
+      next.m_work();
+
+      std::lock_guard lock (m_ready_mutex);
+      m_ready.push_back(next.m_handle);
+    }
+  }
+
+} // namespace gl
@@ -0,0 +1,129 @@
+#ifndef HEADER_ASSET_ASSET_STREAMER_H
+#define HEADER_ASSET_ASSET_STREAMER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "types.hpp"
+#include "task.hpp"
+#include "job/job_system.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  class asset_streamer;
+
+  // What `co_await streamer.run(...)` waits on: the work runs on a worker
+  // thread, and the coroutine resumes with its result on the thread that
+  // calls asset_streamer::poll()
+  template <typename result_type>
+  class async_result {
+    private:
+      asset_streamer &m_streamer;
+      std::function <result_type ()> m_work;
+      std::optional <result_type> m_result;
+
+    public:
+      async_result (asset_streamer&, std::function <result_type ()>&&);
+
+      bool await_ready () const noexcept { return false; }
+      void await_suspend (std::coroutine_handle <>);
+      result_type await_resume ();
+  };
+
+  // Worker threads for the CPU side of asset loading (parsing, cache reads
+  // and writes) and a queue of coroutines to resume on the GL thread once
+  // their data is ready, which is where the buffer uploads happen.
+  //
+  // The workers block on files, so they are threads of their own rather than
+  // jobs; work they can split, like parsing a large mesh, goes to the job
+  // system they are given.
+  class asset_streamer {
+    private:
+      struct job {
+        std::function <void ()> m_work;
+        std::coroutine_handle <> m_handle;
+      };
+
+      job_system &m_job_system;
+
+      std::vector <std::thread> m_workers;
+      std::deque <job> m_jobs;
+      std::mutex m_jobs_mutex;
+      std::condition_variable m_jobs_available;
+      bool m_stopping;
+
+      std::vector <std::coroutine_handle <>> m_ready;
+      std::mutex m_ready_mutex;
+
+      std::atomic <u32> m_pending_count;
+
+    public:
+      // 0 worker threads picks one less than the hardware threads (at least 1),
+      // leaving one for the GL thread
+      asset_streamer (job_system&, u32 = 0);
+      ~asset_streamer ();
+
+      asset_streamer (const asset_streamer&) = delete;
+      asset_streamer& operator = (const asset_streamer&) = delete;
+
+      template <typename function_type>
+      async_result <std::invoke_result_t <function_type>> run (function_type&&);
+
+      // Resumes every coroutine whose work has finished, on the calling thread.
+      // Called once per frame by the GL thread. Returns how many were resumed
+      u32 poll ();
+
+      // Number of coroutines waiting on a worker or on poll()
+      u32 get_pending_count () const;
+
+      job_system& get_job_system ();
+
+    private:
+      template <typename result_type>
+      friend class async_result;
+
+      void submit (std::function <void ()>&&, std::coroutine_handle <>);
+      void work ();
+  };
+
+  template <typename result_type>
+  async_result <result_type>::async_result (asset_streamer &streamer, std::function <result_type ()> &&work)
+    : m_streamer (streamer),
+      m_work (std::move(work)),
+      m_result () {
+
+  }
+
+  template <typename result_type>
+  void async_result <result_type>::await_suspend (std::coroutine_handle <> handle) {
+    // The awaitable lives in the suspended coroutine frame, which stays alive
+    // until the coroutine is resumed (or destroyed by the streamer)
+    m_streamer.submit([this] { m_result.emplace(m_work()); }, handle);
+  }
+
+  template <typename result_type>
+  result_type async_result <result_type>::await_resume () {
+    return std::move(*m_result);
+  }
+
+  template <typename function_type>
+  async_result <std::invoke_result_t <function_type>> asset_streamer::run (function_type &&function) {
+    using result_type = std::invoke_result_t <function_type>;
+    static_assert(not std::is_void_v <result_type>, "asset_streamer::run needs work that returns its result");
+
+    return async_result <result_type> (*this, std::forward <function_type> (function));
+  }
+
+} // namespace gl
+
+#endif // HEADER_ASSET_ASSET_STREAMER_H
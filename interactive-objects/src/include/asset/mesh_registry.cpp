@@ -0,0 +1,38 @@
+#include <algorithm>
+
+#include "mesh_registry.hpp"
+
+namespace gl {
+
+  std::shared_ptr <gpu_mesh> mesh_registry::find (u64 key) {
+    auto it = m_meshes.find(key);
+
+    if (it == m_meshes.end())
+      return nullptr;
+
+    auto mesh = it->second.lock();
+
+    if (not mesh)
+      m_meshes.erase(it);
+
+    return mesh;
+  }
+
+  std::shared_ptr <gpu_mesh> mesh_registry::create (u64 key, vertex_format format) {
+    // Entries of meshes nobody uses anymore are dropped as new ones come in
+    std::erase_if(m_meshes, [] (const auto &entry) {
+      return entry.second.expired();
+    });
+
+    auto mesh = std::make_shared <gpu_mesh> (format);
+    m_meshes[key] = mesh;
+    return mesh;
+  }
+
+  u32 mesh_registry::get_mesh_count () const {
+    return std::count_if(m_meshes.begin(), m_meshes.end(), [] (const auto &entry) {
+      return not entry.second.expired();
+    });
+  }
+
+} // namespace gl
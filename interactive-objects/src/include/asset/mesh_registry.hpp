@@ -0,0 +1,40 @@
+#ifndef HEADER_ASSET_MESH_REGISTRY_H
+#define HEADER_ASSET_MESH_REGISTRY_H
+
+#include <memory>
+#include <unordered_map>
+
+#include "types.hpp"
+#include "mesh/gpu_mesh.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // Meshes currently in GPU memory by asset key, so objects drawing the same
+  // asset share one set of buffers. The registry does not own the meshes:
+  // they are reference counted by the objects using them and freed with the
+  // last one. Only used from the GL thread
+  class mesh_registry {
+    private:
+      std::unordered_map <u64, std::weak_ptr <gpu_mesh>> m_meshes;
+
+    public:
+      mesh_registry () = default;
+
+      mesh_registry (const mesh_registry&) = delete;
+      mesh_registry& operator = (const mesh_registry&) = delete;
+
+      // The live mesh for a key, or nullptr
+      std::shared_ptr <gpu_mesh> find (u64);
+
+      // Creates an empty mesh for a key, which the caller loads
+      std::shared_ptr <gpu_mesh> create (u64, vertex_format);
+
+      // Number of distinct live meshes
+      u32 get_mesh_count () const;
+  };
+
+} // namespace gl
+
+#endif // HEADER_ASSET_MESH_REGISTRY_H
@@ -0,0 +1,25 @@
+#ifndef HEADER_ASSET_TASK_H
+#define HEADER_ASSET_TASK_H
+
+#include <coroutine>
+#include <exception>
+
+namespace gl {
+
+  // Fire and forget coroutine. It starts running as soon as it is called and
+  // frees its own frame when it finishes, so the caller keeps no handle to it.
+  // Whoever a task suspends on (see asset_streamer) is responsible for
+  // resuming it, or destroying it if it never will be.
+  struct task {
+    struct promise_type {
+      task get_return_object () noexcept { return {}; }
+      std::suspend_never initial_suspend () noexcept { return {}; }
+      std::suspend_never final_suspend () noexcept { return {}; }
+      void return_void () noexcept {}
+      void unhandled_exception () noexcept { std::terminate(); }
+    };
+  };
+
+} // namespace gl
+
+#endif // HEADER_ASSET_TASK_H
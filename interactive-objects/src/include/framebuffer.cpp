@@ -0,0 +1,76 @@
+#include <algorithm>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "framebuffer.hpp"
+
+namespace gl {
+
+  framebuffer::framebuffer (u32 width, u32 height)
+    : m_id (0),
+      m_color (0),
+      m_depth_stencil (0),
+      m_width (width),
+      m_height (height) {
+    glGenFramebuffers(1, &m_id);
+    glGenRenderbuffers(1, &m_color);
+    glGenRenderbuffers(1, &m_depth_stencil);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, m_color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_width, m_height);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depth_stencil);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_width, m_height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    bind();
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depth_stencil);
+  }
+
+  framebuffer::~framebuffer () {
+    glDeleteFramebuffers(1, &m_id);
+    glDeleteRenderbuffers(1, &m_color);
+    glDeleteRenderbuffers(1, &m_depth_stencil);
+  }
+
+  void framebuffer::bind () const {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_id);
+  }
+
+  void framebuffer::unbind () const {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  }
+
+  bool framebuffer::is_complete () const {
+    bind();
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+  }
+
+  std::vector <byte> framebuffer::read_pixels () const {
+    u64 row_size = 3 * static_cast <u64> (m_width);
+    std::vector <byte> pixels (row_size * m_height);
+
+    bind();
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    // GL rows go from bottom to top
+    for (u32 y = 0; y < m_height / 2; ++y)
+      std::swap_ranges(
+        pixels.begin() + y * row_size, pixels.begin() + (y + 1) * row_size,
+        pixels.begin() + (m_height - 1 - y) * row_size
+      );
+
+    return pixels;
+  }
+
+  u32 framebuffer::get_width () const {
+    return m_width;
+  }
+
+  u32 framebuffer::get_height () const {
+    return m_height;
+  }
+
+} // namespace gl
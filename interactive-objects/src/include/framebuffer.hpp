@@ -0,0 +1,43 @@
+#ifndef HEADER_FRAMEBUFFER_H
+#define HEADER_FRAMEBUFFER_H
+
+#include <vector>
+
+#include "types.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // An offscreen render target with an RGBA8 color buffer and a combined
+  // 24 bit depth, 8 bit stencil buffer, what the window would have
+  class framebuffer {
+    private:
+      u32 m_id;
+      u32 m_color;
+      u32 m_depth_stencil;
+      u32 m_width;
+      u32 m_height;
+
+    public:
+      framebuffer (u32, u32);
+      ~framebuffer ();
+
+      framebuffer (const framebuffer&) = delete;
+      framebuffer& operator = (const framebuffer&) = delete;
+
+      void bind () const;
+      void unbind () const;
+
+      bool is_complete () const;
+
+      // The color buffer as RGB bytes, rows from top to bottom
+      std::vector <byte> read_pixels () const;
+
+      u32 get_width () const;
+      u32 get_height () const;
+  };
+
+} // namespace gl
+
+#endif // HEADER_FRAMEBUFFER_H
@@ -0,0 +1,141 @@
+#if defined(__AVX__)
+  #include <immintrin.h>
+  #define FRUSTUM_LANES 8
+#elif defined(__SSE2__)
+  #include <emmintrin.h>
+  #define FRUSTUM_LANES 4
+#endif
+
+#include <algorithm>
+
+#include "frustum.hpp"
+
+namespace gl {
+
+  // Just what cull needs, on the widest registers the build targets, see
+  // transform_storage.cpp
+#if defined(__AVX__)
+  using simd_lanes = __m256;
+
+  static inline simd_lanes simd_load (const f32 *p) { return _mm256_loadu_ps(p); }
+  static inline simd_lanes simd_splat (f32 a) { return _mm256_set1_ps(a); }
+  static inline simd_lanes simd_add (simd_lanes a, simd_lanes b) { return _mm256_add_ps(a, b); }
+  static inline simd_lanes simd_mul (simd_lanes a, simd_lanes b) { return _mm256_mul_ps(a, b); }
+  static inline simd_lanes simd_or (simd_lanes a, simd_lanes b) { return _mm256_or_ps(a, b); }
+  static inline simd_lanes simd_less (simd_lanes a, simd_lanes b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+  static inline u32 simd_mask (simd_lanes a) { return _mm256_movemask_ps(a); }
+#elif defined(__SSE2__)
+  using simd_lanes = __m128;
+
+  static inline simd_lanes simd_load (const f32 *p) { return _mm_loadu_ps(p); }
+  static inline simd_lanes simd_splat (f32 a) { return _mm_set1_ps(a); }
+  static inline simd_lanes simd_add (simd_lanes a, simd_lanes b) { return _mm_add_ps(a, b); }
+  static inline simd_lanes simd_mul (simd_lanes a, simd_lanes b) { return _mm_mul_ps(a, b); }
+  static inline simd_lanes simd_or (simd_lanes a, simd_lanes b) { return _mm_or_ps(a, b); }
+  static inline simd_lanes simd_less (simd_lanes a, simd_lanes b) { return _mm_cmplt_ps(a, b); }
+  static inline u32 simd_mask (simd_lanes a) { return _mm_movemask_ps(a); }
+#endif
+
+  // A point p is inside the clip volume when -w <= x, y, z <= w, with
+  // (x, y, z, w) = m * p. Each of the six inequalities is a plane made of
+  // the last row of m plus or minus another row
+  frustum::frustum (const glm::mat4 &m) {
+    for (u32 axis = 0; axis < 3; ++axis)
+      for (u32 side = 0; side < 2; ++side) {
+        glm::vec4 &plane = m_planes[2 * axis + side];
+        f32 sign = side == 0 ? 1.0f : -1.0f;
+
+        for (u32 column = 0; column < 4; ++column)
+          plane[column] = m[column][3] + sign * m[column][axis];
+
+        plane /= glm::length(glm::vec3(plane));
+      }
+  }
+
+  bool frustum::intersects (const glm::vec4 &sphere) const {
+    for (const auto &plane: m_planes)
+      if (glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w < -sphere.w)
+        return false;
+
+    return true;
+  }
+
+  frustum_culler::frustum_culler ()
+    : m_center_x (),
+      m_center_y (),
+      m_center_z (),
+      m_radius (),
+      m_visible () {
+
+  }
+
+  void frustum_culler::resize (u32 size) {
+    m_center_x.resize(size);
+    m_center_y.resize(size);
+    m_center_z.resize(size);
+    m_radius.resize(size);
+    m_visible.resize(size);
+  }
+
+  void frustum_culler::set_sphere (u32 index, const glm::vec4 &sphere) {
+    m_center_x[index] = sphere.x;
+    m_center_y[index] = sphere.y;
+    m_center_z[index] = sphere.z;
+    m_radius[index] = sphere.w;
+  }
+
+  void frustum_culler::cull (const frustum &f, u32 begin, u32 end) {
+    u32 i = begin;
+
+#ifdef FRUSTUM_LANES
+    simd_lanes planes[6][4];
+
+    for (u32 p = 0; p < 6; ++p)
+      for (u32 c = 0; c < 4; ++c)
+        planes[p][c] = simd_splat(f.m_planes[p][c]);
+
+    const simd_lanes zero = simd_splat(0.0f);
+
+    for (; i + FRUSTUM_LANES <= end; i += FRUSTUM_LANES) {
+      simd_lanes x = simd_load(m_center_x.data() + i);
+      simd_lanes y = simd_load(m_center_y.data() + i);
+      simd_lanes z = simd_load(m_center_z.data() + i);
+      simd_lanes r = simd_load(m_radius.data() + i);
+
+      // Outside once the sphere is wholly behind any plane, or right away
+      // with a negative radius
+      simd_lanes outside = simd_less(r, zero);
+
+      for (u32 p = 0; p < 6; ++p) {
+        simd_lanes distance = simd_add(simd_add(simd_mul(planes[p][0], x), simd_mul(planes[p][1], y)), simd_add(simd_mul(planes[p][2], z), planes[p][3]));
+        outside = simd_or(outside, simd_less(simd_add(distance, r), zero));
+      }
+
+      for (u32 mask = simd_mask(outside), lane = 0; lane < FRUSTUM_LANES; ++lane)
+        m_visible[i + lane] = ((mask >> lane) & 1) ^ 1;
+    }
+#endif
+
+    cull_scalar(f, i, end);
+  }
+
+  bool frustum_culler::is_visible (u32 index) const {
+    return m_visible[index];
+  }
+
+  u32 frustum_culler::get_visible_count () const {
+    return std::count(m_visible.begin(), m_visible.end(), 1);
+  }
+
+  u32 frustum_culler::get_size () const {
+    return m_radius.size();
+  }
+
+  // The spheres past the last full register, or all of them without SIMD
+  void frustum_culler::cull_scalar (const frustum &f, u32 begin, u32 end) {
+    for (u32 i = begin; i < end; ++i)
+      m_visible[i] = m_radius[i] >= 0.0f
+        and f.intersects(glm::vec4(m_center_x[i], m_center_y[i], m_center_z[i], m_radius[i]));
+  }
+
+} // namespace gl
@@ -0,0 +1,63 @@
+#ifndef HEADER_FRUSTUM_H
+#define HEADER_FRUSTUM_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "types.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // The six planes bounding what a view projection matrix sees, as
+  // (normal, distance) with normals of unit length pointing inwards: a point
+  // p is inside a plane when dot(normal, p) + distance >= 0
+  struct frustum {
+    glm::vec4 m_planes[6];
+
+    // Left, right, bottom, top, near and far, in that order
+    frustum (const glm::mat4&);
+
+    // Whether a sphere as (center, radius) is at least partly inside. Spheres
+    // near a corner may pass without being seen
+    bool intersects (const glm::vec4&) const;
+  };
+
+  // Bounding spheres of many objects as a structure of arrays, tested
+  // against a frustum 4 (SSE) or 8 (AVX) at a time.
+  //
+  // Spheres with a negative radius are never visible, they stand in for
+  // objects that are not drawn at all
+  class frustum_culler {
+    private:
+      std::vector <f32> m_center_x;
+      std::vector <f32> m_center_y;
+      std::vector <f32> m_center_z;
+      std::vector <f32> m_radius;
+      std::vector <u8> m_visible;
+
+    public:
+      frustum_culler ();
+
+      void resize (u32);
+      void set_sphere (u32, const glm::vec4&);
+
+      // Tests the spheres of [begin, end). Disjoint ranges may be tested on
+      // different threads, best starting at multiples of 8
+      void cull (const frustum&, u32, u32);
+
+      bool is_visible (u32) const;
+
+      // Spheres found visible by the last cull of every range
+      u32 get_visible_count () const;
+      u32 get_size () const;
+
+    private:
+      void cull_scalar (const frustum&, u32, u32);
+  };
+
+} // namespace gl
+
+#endif // HEADER_FRUSTUM_H
@@ -0,0 +1,62 @@
+#include <algorithm>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "instance_batch.hpp"
+
+namespace gl {
+
+  // Instances the first instance buffer has room for, it doubles from there
+  static constexpr u32 initial_instance_capacity = 256;
+
+  instance_batch::instance_batch ()
+    : m_vertex_array (),
+      m_instance_layout (1),
+      m_instance_buffer (nullptr),
+      m_instance_capacity (0),
+      m_instances (),
+      m_source (nullptr),
+      m_source_generation (0) {
+    for (u32 i = 0; i < 6; ++i)
+      m_instance_layout.push <f32> (4);
+  }
+
+  void instance_batch::add (const instance_data &instance) {
+    m_instances.push_back(instance);
+  }
+
+  void instance_batch::clear () {
+    m_instances.clear();
+  }
+
+  void instance_batch::upload (const mesh_buffer &source) {
+    if (m_source != &source or m_source_generation != source.get_generation()) {
+      m_vertex_array.add_buffer(source.get_vertex_buffer(), source.get_layout());
+      m_source = &source;
+      m_source_generation = source.get_generation();
+    }
+
+    if (m_instances.size() > m_instance_capacity) {
+      m_instance_capacity = std::max <u32> (m_instances.size(), std::max(2 * m_instance_capacity, initial_instance_capacity));
+      m_instance_buffer = std::make_unique <vertex_buffer> (nullptr, m_instance_capacity * sizeof(instance_data), buffer_usage::stream_draw);
+      m_vertex_array.add_buffer(*m_instance_buffer, m_instance_layout, first_instance_location);
+    }
+
+    // Last frame's draws may still read the buffer, writing into the same
+    // storage would wait for them
+    if (not m_instances.empty()) {
+      m_instance_buffer->orphan(m_instance_capacity * sizeof(instance_data), buffer_usage::stream_draw);
+      m_instance_buffer->update(0, m_instances.data(), m_instances.size() * sizeof(instance_data));
+    }
+  }
+
+  const vertex_array& instance_batch::get_vertex_array () const {
+    return m_vertex_array;
+  }
+
+  u32 instance_batch::get_instance_count () const {
+    return m_instances.size();
+  }
+
+} // namespace gl
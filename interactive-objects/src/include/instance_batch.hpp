@@ -0,0 +1,72 @@
+#ifndef HEADER_INSTANCE_BATCH_H
+#define HEADER_INSTANCE_BATCH_H
+
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "types.hpp"
+#include "vertex/vertex.hpp"
+#include "mesh/mesh_buffer.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // Per instance attributes of an instanced draw, read by the instanced
+  // vertex shader from locations 2 to 7:
+  //
+  //   2..5  model matrix columns
+  //   6     color
+  //   7     blend, whether to use the vertex colors (0 or 1), palette
+  //         offset and size
+  //
+  // the same record draw_program reads from its texture buffer
+  struct instance_data {
+    glm::mat4 m_model;
+    glm::vec4 m_color;
+    glm::vec4 m_parameters;
+  };
+
+  static_assert(sizeof(instance_data) == 96, "instance_data is six vec4 attributes");
+
+  // Many copies of one mesh drawn with a single draw call. The vertex array
+  // reads the vertices of the mesh's mesh_buffer with divisor 0 and an
+  // instance stream with divisor 1. Instances are gathered every frame with
+  // add and sent with upload
+  class instance_batch {
+    private:
+      static constexpr u32 first_instance_location = 2;
+
+      vertex_array m_vertex_array;
+      vertex_buffer_layout m_instance_layout;
+      std::unique_ptr <vertex_buffer> m_instance_buffer;
+      u32 m_instance_capacity;
+
+      std::vector <instance_data> m_instances;
+
+      // The mesh_buffer the vertex array reads, and its generation then
+      const mesh_buffer *m_source;
+      u32 m_source_generation;
+
+    public:
+      instance_batch ();
+
+      instance_batch (const instance_batch&) = delete;
+      instance_batch& operator = (const instance_batch&) = delete;
+
+      void add (const instance_data&);
+      void clear ();
+
+      // Sends the instances added since the last clear, and points the vertex
+      // array at the vertices of `source` if it does not already
+      void upload (const mesh_buffer&);
+
+      const vertex_array& get_vertex_array () const;
+      u32 get_instance_count () const;
+  };
+
+} // namespace gl
+
+#endif // HEADER_INSTANCE_BATCH_H
@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "bounds.hpp"
+
+namespace gl {
+
+  bounding_box::bounding_box ()
+    : m_min (std::numeric_limits <f32>::max()),
+      m_max (std::numeric_limits <f32>::lowest())
+  { }
+
+  bounding_box::bounding_box (const glm::vec3 &min, const glm::vec3 &max)
+    : m_min (min),
+      m_max (max)
+  { }
+
+  bool bounding_box::is_empty () const {
+    return m_min.x > m_max.x or m_min.y > m_max.y or m_min.z > m_max.z;
+  }
+
+  glm::vec3 bounding_box::get_center () const {
+    return (m_min + m_max) * 0.5f;
+  }
+
+  // Half the size along every axis
+  glm::vec3 bounding_box::get_extent () const {
+    return (m_max - m_min) * 0.5f;
+  }
+
+  bounding_box compute_bounds (const std::vector <glm::vec3> &positions) {
+    bounding_box bounds;
+
+    for (auto &p: positions) {
+      bounds.m_min = glm::min(bounds.m_min, p);
+      bounds.m_max = glm::max(bounds.m_max, p);
+    }
+
+    return bounds;
+  }
+
+  glm::vec4 compute_bounding_sphere (const std::vector <glm::vec3> &positions, const bounding_box &bounds) {
+    glm::vec3 center = bounds.get_center();
+    f32 radius_squared = 0.0f;
+
+    for (auto &p: positions) {
+      glm::vec3 offset = p - center;
+      radius_squared = std::max(radius_squared, glm::dot(offset, offset));
+    }
+
+    return glm::vec4(center, std::sqrt(radius_squared));
+  }
+
+} // namespace gl
@@ -0,0 +1,36 @@
+#ifndef HEADER_MESH_BOUNDS_H
+#define HEADER_MESH_BOUNDS_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "types.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // Axis aligned bounding box in object space. An empty box has m_min > m_max
+  struct bounding_box {
+    glm::vec3 m_min;
+    glm::vec3 m_max;
+
+    bounding_box ();
+    bounding_box (const glm::vec3&, const glm::vec3&);
+
+    bool is_empty () const;
+    glm::vec3 get_center () const;
+    glm::vec3 get_extent () const;
+  };
+
+  bounding_box compute_bounds (const std::vector <glm::vec3>&);
+
+  // Sphere around the center of the bounds, as (center, radius), just large
+  // enough to hold every position. Tighter than the sphere around the box
+  // for round meshes
+  glm::vec4 compute_bounding_sphere (const std::vector <glm::vec3>&, const bounding_box&);
+
+} // namespace gl
+
+#endif // HEADER_MESH_BOUNDS_H
@@ -0,0 +1,111 @@
+#include <glad/glad.h>
+
+#include "gpu_mesh.hpp"
+
+namespace gl {
+
+  gpu_mesh::gpu_mesh (vertex_format format)
+    : m_vertex_format (format),
+      m_bounds (),
+      m_dequantize (1.0f),
+      m_bounding_sphere (0.0f),
+      m_lods (),
+      m_vertex_stride (get_vertex_layout(format).get_stride()),
+      m_buffer (nullptr),
+      m_allocation ()
+  {
+
+  }
+
+  gpu_mesh::~gpu_mesh () {
+    if (m_buffer)
+      m_buffer->free(m_allocation);
+  }
+
+  gpu_mesh& gpu_mesh::load (const void *vertices, u32 size, const u32 *indices, u32 count) {
+    if (m_buffer)
+      m_buffer->free(m_allocation);
+
+    // Indices are relative to the mesh, so 16 bits cover meshes of up to
+    // 65536 vertices whatever else the buffer holds
+    u32 vertex_count = size / m_vertex_stride;
+    u32 index_type = vertex_count <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    m_buffer = mesh_buffer::get(m_vertex_format, index_type);
+    m_allocation = m_buffer->allocate(vertices, vertex_count, indices, count);
+
+    // A single level covering everything, until set_lods says otherwise
+    m_lods.assign(1, {0, count, 0.0f});
+    return *this;
+  }
+
+  // Bounds of the mesh in object space. Quantized vertices are relative to
+  // them, so they have to be set before the mesh is drawn
+  gpu_mesh& gpu_mesh::set_bounds (const bounding_box &bounds) {
+    m_bounds = bounds;
+    m_dequantize = get_dequantize_matrix(m_vertex_format, bounds);
+    return *this;
+  }
+
+  // Computed from the positions when the mesh is built, see
+  // compute_bounding_sphere
+  gpu_mesh& gpu_mesh::set_bounding_sphere (const glm::vec4 &sphere) {
+    m_bounding_sphere = sphere;
+    return *this;
+  }
+
+  // Levels of detail within the loaded index buffer, see build_lod_chain
+  gpu_mesh& gpu_mesh::set_lods (const std::vector <mesh_lod> &lods) {
+    if (not lods.empty())
+      m_lods = lods;
+
+    return *this;
+  }
+
+  vertex_format gpu_mesh::get_vertex_format () const {
+    return m_vertex_format;
+  }
+
+  u32 gpu_mesh::get_vertex_stride () const {
+    return m_vertex_stride;
+  }
+
+  const bounding_box& gpu_mesh::get_bounds () const {
+    return m_bounds;
+  }
+
+  const glm::vec4& gpu_mesh::get_bounding_sphere () const {
+    return m_bounding_sphere;
+  }
+
+  const glm::mat4& gpu_mesh::get_dequantize () const {
+    return m_dequantize;
+  }
+
+  const std::vector <mesh_lod>& gpu_mesh::get_lods () const {
+    return m_lods;
+  }
+
+  // Whether load() has uploaded the buffers yet, streamed meshes are not
+  // drawable before that
+  bool gpu_mesh::is_resident () const {
+    return m_buffer != nullptr;
+  }
+
+  const mesh_allocation& gpu_mesh::get_allocation () const {
+    return m_allocation;
+  }
+
+  const mesh_buffer& gpu_mesh::get_buffer () const {
+    return *m_buffer;
+  }
+
+  const vertex_array& gpu_mesh::get_vertex_array () const {
+    return m_buffer->get_vertex_array();
+  }
+
+  const index_buffer& gpu_mesh::get_index_buffer () const {
+    return m_buffer->get_index_buffer();
+  }
+
+} // namespace gl
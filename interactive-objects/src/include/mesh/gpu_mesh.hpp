@@ -0,0 +1,68 @@
+#ifndef HEADER_MESH_GPU_MESH_H
+#define HEADER_MESH_GPU_MESH_H
+
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "types.hpp"
+#include "vertex/vertex.hpp"
+#include "mesh/bounds.hpp"
+#include "mesh/mesh_buffer.hpp"
+#include "mesh/mesh_simplifier.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // A mesh in GPU memory, a range of the mesh_buffer of its vertex format,
+  // and what describes it: the bounds quantized positions are relative to and
+  // the levels of detail within its indices. Shared by every object drawing
+  // the mesh, see mesh_registry
+  class gpu_mesh {
+    private:
+      vertex_format m_vertex_format;
+      bounding_box m_bounds;
+      glm::mat4 m_dequantize;
+
+      // Object space (center, radius), a radius of 0 until it is known
+      glm::vec4 m_bounding_sphere;
+
+      // Ranges of the index buffer, the full detail one first
+      std::vector <mesh_lod> m_lods;
+
+      u32 m_vertex_stride;
+      std::shared_ptr <mesh_buffer> m_buffer;
+      mesh_allocation m_allocation;
+
+    public:
+      gpu_mesh (vertex_format = vertex_format::full);
+      ~gpu_mesh ();
+
+      gpu_mesh (const gpu_mesh&) = delete;
+      gpu_mesh& operator = (const gpu_mesh&) = delete;
+
+      gpu_mesh& load (const void*, u32, const u32*, u32);
+      gpu_mesh& set_bounds (const bounding_box&);
+      gpu_mesh& set_bounding_sphere (const glm::vec4&);
+      gpu_mesh& set_lods (const std::vector <mesh_lod>&);
+
+      vertex_format get_vertex_format () const;
+      u32 get_vertex_stride () const;
+      const bounding_box& get_bounds () const;
+      const glm::vec4& get_bounding_sphere () const;
+      const glm::mat4& get_dequantize () const;
+      const std::vector <mesh_lod>& get_lods () const;
+      bool is_resident () const;
+
+      // Level of detail ranges are relative to the allocation's first index
+      const mesh_allocation& get_allocation () const;
+      const mesh_buffer& get_buffer () const;
+      const vertex_array& get_vertex_array () const;
+      const index_buffer& get_index_buffer () const;
+  };
+
+} // namespace gl
+
+#endif // HEADER_MESH_GPU_MESH_H
@@ -0,0 +1,115 @@
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped_file.hpp"
+
+namespace gl {
+
+  mapped_file::mapped_file ()
+    : m_data (nullptr),
+      m_size (0),
+      m_is_open (false)
+  { }
+
+  mapped_file::mapped_file (const std::string &filepath)
+    : m_data (nullptr),
+      m_size (0),
+      m_is_open (false) {
+    open(filepath);
+  }
+
+  mapped_file::mapped_file (mapped_file &&other) noexcept
+    : m_data (other.m_data),
+      m_size (other.m_size),
+      m_is_open (other.m_is_open) {
+    other.m_data = nullptr;
+    other.m_size = 0;
+    other.m_is_open = false;
+  }
+
+  mapped_file& mapped_file::operator = (mapped_file &&other) noexcept {
+    if (this != &other) {
+      close();
+      m_data = other.m_data;
+      m_size = other.m_size;
+      m_is_open = other.m_is_open;
+      other.m_data = nullptr;
+      other.m_size = 0;
+      other.m_is_open = false;
+    }
+    return *this;
+  }
+
+  mapped_file::~mapped_file () {
+    close();
+  }
+
+  bool mapped_file::open (const std::string &filepath) {
+    close();
+
+    i32 fd = ::open(filepath.c_str(), O_RDONLY);
+
+    if (fd == -1) {
+      std::cerr << "file (" << filepath << ") could not be opened" << std::endl;
+      return false;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) == -1) {
+      std::cerr << "file (" << filepath << ") could not be stat'd" << std::endl;
+      ::close(fd);
+      return false;
+    }
+
+    // mmap does not accept zero length mappings, an empty file is still a valid
+    // (empty) view so we leave m_data as nullptr
+    if (info.st_size > 0) {
+      void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+      if (data == MAP_FAILED) {
+        std::cerr << "file (" << filepath << ") could not be mapped" << std::endl;
+        ::close(fd);
+        return false;
+      }
+
+      // the whole file is scanned front to back by the parsers
+      madvise(data, info.st_size, MADV_SEQUENTIAL);
+      m_data = static_cast <const char*> (data);
+    }
+
+    m_size = info.st_size;
+    m_is_open = true;
+
+    // the mapping keeps its own reference to the file
+    ::close(fd);
+
+    return true;
+  }
+
+  void mapped_file::close () {
+    if (m_data != nullptr)
+      munmap(const_cast <char*> (m_data), m_size);
+
+    m_data = nullptr;
+    m_size = 0;
+    m_is_open = false;
+  }
+
+  bool mapped_file::is_open () const {
+    return m_is_open;
+  }
+
+  const char* mapped_file::get_data () const {
+    return m_data;
+  }
+
+  u64 mapped_file::get_size () const {
+    return m_size;
+  }
+
+} // namespace gl
@@ -0,0 +1,40 @@
+#ifndef HEADER_MESH_MAPPED_FILE_H
+#define HEADER_MESH_MAPPED_FILE_H
+
+#include <string>
+
+#include "types.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // Read-only memory mapping of a whole file. The mapping lives as long as the
+  // object, so views into get_data() must not outlive it.
+  class mapped_file {
+    private:
+      const char *m_data;
+      u64 m_size;
+      bool m_is_open;
+
+    public:
+      mapped_file ();
+      mapped_file (const std::string&);
+      mapped_file (mapped_file&&) noexcept;
+      mapped_file& operator = (mapped_file&&) noexcept;
+      ~mapped_file ();
+
+      mapped_file (const mapped_file&) = delete;
+      mapped_file& operator = (const mapped_file&) = delete;
+
+      bool open (const std::string&);
+      void close ();
+
+      bool is_open () const;
+      const char* get_data () const;
+      u64 get_size () const;
+  };
+
+} // namespace gl
+
+#endif // HEADER_MESH_MAPPED_FILE_H
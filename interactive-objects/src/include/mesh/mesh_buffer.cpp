@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "mesh_buffer.hpp"
+
+namespace gl {
+
+  // Room for a few small meshes before the first grow
+  static constexpr u32 initial_vertex_capacity = 1 << 16;
+  static constexpr u32 initial_index_capacity = 3 << 16;
+
+  static void copy_buffer (u32, u32, u32);
+
+  range_allocator::range_allocator (u32 capacity)
+    : m_free (),
+      m_capacity (0) {
+    grow(capacity);
+  }
+
+  u32 range_allocator::allocate (u32 size) {
+    for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+      auto [offset, free_size] = *it;
+
+      if (free_size < size)
+        continue;
+
+      m_free.erase(it);
+
+      if (free_size > size)
+        m_free.emplace(offset + size, free_size - size);
+
+      return offset;
+    }
+
+    return invalid;
+  }
+
+  void range_allocator::free (u32 offset, u32 size) {
+    if (size == 0)
+      return;
+
+    auto next = m_free.lower_bound(offset);
+
+    if (next != m_free.end() and offset + size == next->first) {
+      size += next->second;
+      next = m_free.erase(next);
+    }
+
+    if (next != m_free.begin()) {
+      auto previous = std::prev(next);
+
+      if (previous->first + previous->second == offset) {
+        previous->second += size;
+        return;
+      }
+    }
+
+    m_free.emplace(offset, size);
+  }
+
+  void range_allocator::grow (u32 capacity) {
+    if (capacity <= m_capacity)
+      return;
+
+    u32 old_capacity = m_capacity;
+    m_capacity = capacity;
+    free(old_capacity, capacity - old_capacity);
+  }
+
+  u32 range_allocator::get_capacity () const {
+    return m_capacity;
+  }
+
+  mesh_buffer::mesh_buffer (vertex_format format, u32 index_type)
+    : m_format (format),
+      m_layout (get_vertex_layout(format)),
+      m_index_type (index_type),
+      m_vertex_array (),
+      m_vertex_buffer (nullptr),
+      m_index_buffer (nullptr),
+      m_vertices (),
+      m_indices (),
+      m_generation (0) {
+    grow(initial_vertex_capacity, initial_index_capacity);
+  }
+
+  std::shared_ptr <mesh_buffer> mesh_buffer::get (vertex_format format, u32 index_type) {
+    static std::map <std::pair <vertex_format, u32>, std::weak_ptr <mesh_buffer>> buffers;
+
+    auto &entry = buffers[{format, index_type}];
+    auto buffer = entry.lock();
+
+    if (not buffer) {
+      buffer = std::make_shared <mesh_buffer> (format, index_type);
+      entry = buffer;
+    }
+
+    return buffer;
+  }
+
+  mesh_allocation mesh_buffer::allocate (const void *vertices, u32 vertex_count, const u32 *indices, u32 index_count) {
+    u32 base_vertex = m_vertices.allocate(vertex_count);
+    u32 first_index = m_indices.allocate(index_count);
+
+    if (base_vertex == range_allocator::invalid or first_index == range_allocator::invalid) {
+      if (base_vertex != range_allocator::invalid)
+        m_vertices.free(base_vertex, vertex_count);
+
+      if (first_index != range_allocator::invalid)
+        m_indices.free(first_index, index_count);
+
+      grow(
+        std::max(2 * m_vertices.get_capacity(), m_vertices.get_capacity() + vertex_count),
+        std::max(2 * m_indices.get_capacity(), m_indices.get_capacity() + index_count)
+      );
+
+      base_vertex = m_vertices.allocate(vertex_count);
+      first_index = m_indices.allocate(index_count);
+    }
+
+    u32 stride = m_layout.get_stride();
+    m_vertex_buffer->update(base_vertex * stride, vertices, vertex_count * stride);
+
+    if (m_index_type == GL_UNSIGNED_SHORT) {
+      std::vector <u16> narrow (indices, indices + index_count);
+      m_index_buffer->update(first_index, narrow.data(), index_count);
+    }
+    else {
+      m_index_buffer->update(first_index, indices, index_count);
+    }
+
+    return {static_cast <i32> (base_vertex), vertex_count, first_index, index_count};
+  }
+
+  void mesh_buffer::free (const mesh_allocation &allocation) {
+    m_vertices.free(allocation.m_base_vertex, allocation.m_vertex_count);
+    m_indices.free(allocation.m_first_index, allocation.m_index_count);
+  }
+
+  const vertex_array& mesh_buffer::get_vertex_array () const {
+    return m_vertex_array;
+  }
+
+  const vertex_buffer& mesh_buffer::get_vertex_buffer () const {
+    return *m_vertex_buffer;
+  }
+
+  const vertex_buffer_layout& mesh_buffer::get_layout () const {
+    return m_layout;
+  }
+
+  const index_buffer& mesh_buffer::get_index_buffer () const {
+    return *m_index_buffer;
+  }
+
+  u32 mesh_buffer::get_generation () const {
+    return m_generation;
+  }
+
+  // Moves the contents into larger buffers, the allocations stay valid
+  void mesh_buffer::grow (u32 vertex_capacity, u32 index_capacity) {
+    u32 stride = m_layout.get_stride();
+
+    if (vertex_capacity > m_vertices.get_capacity()) {
+      auto buffer = std::make_unique <vertex_buffer> (nullptr, vertex_capacity * stride);
+
+      if (m_vertex_buffer)
+        copy_buffer(m_vertex_buffer->get_id(), buffer->get_id(), m_vertices.get_capacity() * stride);
+
+      m_vertex_buffer = std::move(buffer);
+      m_vertex_array.add_buffer(*m_vertex_buffer, m_layout);
+      m_vertices.grow(vertex_capacity);
+      ++m_generation;
+    }
+
+    if (index_capacity > m_indices.get_capacity()) {
+      auto buffer = std::make_unique <index_buffer> (m_index_type, index_capacity);
+
+      if (m_index_buffer)
+        copy_buffer(m_index_buffer->get_id(), buffer->get_id(), m_indices.get_capacity() * buffer->get_type_size());
+
+      m_index_buffer = std::move(buffer);
+      m_indices.grow(index_capacity);
+    }
+  }
+
+  void copy_buffer (u32 from, u32 to, u32 size) {
+    glBindBuffer(GL_COPY_READ_BUFFER, from);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, to);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  }
+
+} // namespace gl
@@ -0,0 +1,95 @@
+#ifndef HEADER_MESH_MESH_BUFFER_H
+#define HEADER_MESH_MESH_BUFFER_H
+
+#include <map>
+#include <memory>
+
+#include "types.hpp"
+#include "vertex/vertex.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // First fit allocator of ranges within [0, capacity). Freed ranges are
+  // merged with their free neighbours
+  class range_allocator {
+    private:
+      // offset -> size of every free range
+      std::map <u32, u32> m_free;
+      u32 m_capacity;
+
+    public:
+      static constexpr u32 invalid = ~0u;
+
+      range_allocator (u32 = 0);
+
+      // Returns the offset of the range, or invalid when nothing fits
+      u32 allocate (u32);
+      void free (u32, u32);
+
+      // Adds the space past the current capacity to the free ranges
+      void grow (u32);
+
+      u32 get_capacity () const;
+  };
+
+  // Where a mesh lives in a mesh_buffer. Its indices are relative to
+  // m_base_vertex
+  struct mesh_allocation {
+    i32 m_base_vertex;
+    u32 m_vertex_count;
+    u32 m_first_index;
+    u32 m_index_count;
+  };
+
+  // One vertex buffer and one index buffer, behind a single vertex array,
+  // holding the meshes of a vertex format. Drawing any of them needs no
+  // vertex array or buffer change, only a base vertex and an index range.
+  // The buffers double in size when a mesh does not fit
+  class mesh_buffer {
+    private:
+      vertex_format m_format;
+      vertex_buffer_layout m_layout;
+      u32 m_index_type;
+
+      vertex_array m_vertex_array;
+      std::unique_ptr <vertex_buffer> m_vertex_buffer;
+      std::unique_ptr <index_buffer> m_index_buffer;
+      range_allocator m_vertices;
+      range_allocator m_indices;
+
+      // Bumped whenever the vertex buffer is replaced by a larger one
+      u32 m_generation;
+
+    public:
+      mesh_buffer (vertex_format, u32);
+
+      mesh_buffer (const mesh_buffer&) = delete;
+      mesh_buffer& operator = (const mesh_buffer&) = delete;
+
+      // The buffer shared by the meshes of a format with indices of a type
+      // (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT), created on first use and
+      // freed with the last mesh in it. Only used from the GL thread
+      static std::shared_ptr <mesh_buffer> get (vertex_format, u32);
+
+      // Copies vertices (encoded in the format) and indices into the buffer
+      mesh_allocation allocate (const void*, u32, const u32*, u32);
+      void free (const mesh_allocation&);
+
+      const vertex_array& get_vertex_array () const;
+      const vertex_buffer& get_vertex_buffer () const;
+      const vertex_buffer_layout& get_layout () const;
+      const index_buffer& get_index_buffer () const;
+
+      // Vertex arrays reading get_vertex_buffer () outside of this one have
+      // to be rebuilt once the generation changes
+      u32 get_generation () const;
+
+    private:
+      void grow (u32, u32);
+  };
+
+} // namespace gl
+
+#endif // HEADER_MESH_MESH_BUFFER_H
@@ -0,0 +1,264 @@
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+#include <sys/stat.h>
+
+#include "mesh_cache.hpp"
+
+namespace gl {
+
+  struct source_info {
+    i64 m_mtime;
+    u64 m_size;
+  };
+
+  static bool stat_source (const std::string&, source_info&);
+  static bool hash_source (const std::string&, u64&);
+
+  u64 hash_bytes (const void *data, u64 size, u64 seed) {
+    // FNV-1a, 64 bit
+    const byte *bytes = static_cast <const byte*> (data);
+    u64 hash = seed;
+
+    for (u64 i = 0; i < size; ++i) {
+      hash ^= bytes[i];
+      hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+  }
+
+  mesh_cache::mesh_cache ()
+    : m_file (),
+      m_header (nullptr)
+  { }
+
+  // The mapping stays where it is, so the header pointer moves along
+  mesh_cache::mesh_cache (mesh_cache &&other) noexcept
+    : m_file (std::move(other.m_file)),
+      m_header (other.m_header)
+  {
+    other.m_header = nullptr;
+  }
+
+  mesh_cache& mesh_cache::operator = (mesh_cache &&other) noexcept {
+    if (this != &other) {
+      m_file = std::move(other.m_file);
+      m_header = other.m_header;
+      other.m_header = nullptr;
+    }
+    return *this;
+  }
+
+  mesh_cache::~mesh_cache ()
+  { }
+
+  bool mesh_cache::open (const std::string &source_path, u32 vertex_stride, u64 key) {
+    m_file.close();
+    m_header = nullptr;
+
+    std::string cache_path = get_cache_path(source_path, key);
+    source_info source;
+
+    if (not stat_source(source_path, source) or not std::filesystem::exists(cache_path))
+      return false;
+
+    if (not m_file.open(cache_path) or m_file.get_size() < sizeof(mesh_cache_header))
+      return false;
+
+    const auto *header = reinterpret_cast <const mesh_cache_header*> (m_file.get_data());
+    u64 expected_size = sizeof(mesh_cache_header)
+      + static_cast <u64> (header->m_vertex_count) * header->m_vertex_stride
+      + static_cast <u64> (header->m_index_count) * sizeof(u32)
+      + static_cast <u64> (header->m_lod_count) * sizeof(mesh_lod);
+
+    if (header->m_magic != mesh_cache_header::magic or
+        header->m_version != mesh_cache_header::version or
+        header->m_vertex_stride != vertex_stride or
+        header->m_key != key or
+        header->m_source_size != source.m_size or
+        m_file.get_size() != expected_size) {
+      m_file.close();
+      return false;
+    }
+
+    // Levels of detail are ranges of the index data
+    const auto *lods = reinterpret_cast <const mesh_lod*> (m_file.get_data() + expected_size) - header->m_lod_count;
+
+    for (u32 i = 0; i < header->m_lod_count; ++i) {
+      if (static_cast <u64> (lods[i].m_index_offset) + lods[i].m_index_count > header->m_index_count) {
+        m_file.close();
+        return false;
+      }
+    }
+
+    // The source was touched since the cache was written. If the contents
+    // are still the same, carry the new timestamp over so the next launch
+    // takes the fast path again
+    if (header->m_source_mtime != source.m_mtime) {
+      u64 hash;
+
+      if (not hash_source(source_path, hash) or hash != header->m_source_hash) {
+        m_file.close();
+        return false;
+      }
+
+      std::fstream file (cache_path, std::ios::in | std::ios::out | std::ios::binary);
+      file.seekp(offsetof(mesh_cache_header, m_source_mtime));
+      file.write(reinterpret_cast <const char*> (&source.m_mtime), sizeof(source.m_mtime));
+    }
+
+    m_header = header;
+
+    return true;
+  }
+
+  bool mesh_cache::is_open () const {
+    return m_header != nullptr;
+  }
+
+  const void* mesh_cache::get_vertex_data () const {
+    return m_file.get_data() + sizeof(mesh_cache_header);
+  }
+
+  u32 mesh_cache::get_vertex_count () const {
+    return m_header->m_vertex_count;
+  }
+
+  u32 mesh_cache::get_vertex_stride () const {
+    return m_header->m_vertex_stride;
+  }
+
+  const u32* mesh_cache::get_index_data () const {
+    const char *vertices = static_cast <const char*> (get_vertex_data());
+    return reinterpret_cast <const u32*> (vertices + static_cast <u64> (m_header->m_vertex_count) * m_header->m_vertex_stride);
+  }
+
+  u32 mesh_cache::get_index_count () const {
+    return m_header->m_index_count;
+  }
+
+  std::vector <mesh_lod> mesh_cache::get_lods () const {
+    const mesh_lod *lods = reinterpret_cast <const mesh_lod*> (get_index_data() + m_header->m_index_count);
+    return std::vector <mesh_lod> (lods, lods + m_header->m_lod_count);
+  }
+
+  bounding_box mesh_cache::get_bounds () const {
+    const f32 *min = m_header->m_bounds_min;
+    const f32 *max = m_header->m_bounds_max;
+    return bounding_box({min[0], min[1], min[2]}, {max[0], max[1], max[2]});
+  }
+
+  glm::vec4 mesh_cache::get_bounding_sphere () const {
+    const f32 *sphere = m_header->m_bounding_sphere;
+    return glm::vec4(sphere[0], sphere[1], sphere[2], sphere[3]);
+  }
+
+  bool mesh_cache::write (
+    const std::string &source_path, u64 key,
+    const void *vertices, u32 vertex_stride, u32 vertex_count,
+    const u32 *indices, u32 index_count,
+    const bounding_box &bounds,
+    const glm::vec4 &bounding_sphere,
+    const std::vector <mesh_lod> &lods
+  ) {
+    source_info source;
+    mesh_cache_header header {};
+
+    if (not stat_source(source_path, source) or not hash_source(source_path, header.m_source_hash))
+      return false;
+
+    header.m_magic = mesh_cache_header::magic;
+    header.m_version = mesh_cache_header::version;
+    header.m_vertex_stride = vertex_stride;
+    header.m_vertex_count = vertex_count;
+    header.m_index_count = index_count;
+    header.m_lod_count = lods.size();
+    header.m_source_mtime = source.m_mtime;
+    header.m_source_size = source.m_size;
+    header.m_key = key;
+
+    for (u32 i = 0; i < 3; ++i) {
+      header.m_bounds_min[i] = bounds.m_min[i];
+      header.m_bounds_max[i] = bounds.m_max[i];
+    }
+
+    for (u32 i = 0; i < 4; ++i)
+      header.m_bounding_sphere[i] = bounding_sphere[i];
+
+    // Write to a temporary and rename it over the old cache, so a crash or a
+    // second instance never sees a half written file. The temporary is per
+    // thread since meshes are built concurrently by the asset streamer
+    std::string cache_path = get_cache_path(source_path, key);
+    std::string temporary_path = cache_path + "." + std::to_string(std::hash <std::thread::id> () (std::this_thread::get_id())) + ".tmp";
+
+    {
+      std::ofstream file (temporary_path, std::ios::binary | std::ios::trunc);
+
+      if (not file.is_open()) {
+        std::cerr << "file (" << temporary_path << ") could not be opened for writing" << std::endl;
+        return false;
+      }
+
+      file.write(reinterpret_cast <const char*> (&header), sizeof(header));
+      file.write(static_cast <const char*> (vertices), static_cast <u64> (vertex_count) * vertex_stride);
+      file.write(reinterpret_cast <const char*> (indices), static_cast <u64> (index_count) * sizeof(u32));
+      file.write(reinterpret_cast <const char*> (lods.data()), lods.size() * sizeof(mesh_lod));
+
+      if (not file.good()) {
+        std::cerr << "file (" << temporary_path << ") could not be written" << std::endl;
+        return false;
+      }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary_path, cache_path, error);
+
+    if (error) {
+      std::cerr << "file (" << cache_path << ") could not be replaced: " << error.message() << std::endl;
+      std::filesystem::remove(temporary_path, error);
+      return false;
+    }
+
+    return true;
+  }
+
+  std::string mesh_cache::get_cache_path (const std::string &source_path, u64 key) {
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast <unsigned long long> (key));
+    return source_path + "." + hex + ".mesh";
+  }
+
+  bool stat_source (const std::string &source_path, source_info &source) {
+    struct stat info;
+
+    if (stat(source_path.c_str(), &info) == -1)
+      return false;
+
+#ifdef __APPLE__
+    source.m_mtime = static_cast <i64> (info.st_mtimespec.tv_sec) * 1'000'000'000 + info.st_mtimespec.tv_nsec;
+#else
+    source.m_mtime = static_cast <i64> (info.st_mtim.tv_sec) * 1'000'000'000 + info.st_mtim.tv_nsec;
+#endif
+    source.m_size = info.st_size;
+
+    return true;
+  }
+
+  bool hash_source (const std::string &source_path, u64 &hash) {
+    mapped_file file;
+
+    if (not file.open(source_path))
+      return false;
+
+    hash = hash_bytes(file.get_data(), file.get_size());
+
+    return true;
+  }
+
+} // namespace gl
@@ -0,0 +1,103 @@
+#ifndef HEADER_MESH_MESH_CACHE_H
+#define HEADER_MESH_MESH_CACHE_H
+
+#include <string>
+#include <vector>
+
+#include "types.hpp"
+#include "mapped_file.hpp"
+#include "bounds.hpp"
+#include "mesh_simplifier.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // On-disk layout of a cached mesh:
+  //
+  //   mesh_cache_header
+  //   vertex data   (m_vertex_count * m_vertex_stride bytes, interleaved)
+  //   index data    (m_index_count * sizeof(u32) bytes, every level of detail)
+  //   lod table     (m_lod_count mesh_lod entries)
+  //
+  // The vertex data is stored exactly as it is uploaded to the vertex buffer,
+  // so a cache hit needs no processing at all. The header is 96 bytes which
+  // keeps the vertex and index arrays aligned for direct use from the mapping.
+  struct mesh_cache_header {
+    static constexpr u32 magic = 0x434d4c47; // "GLMC"
+    static constexpr u32 version = 7;
+
+    u32 m_magic;
+    u32 m_version;
+    u32 m_vertex_stride;
+    u32 m_vertex_count;
+    u32 m_index_count;
+    u32 m_lod_count;
+
+    // Identifies the source file the cache was built from. The modification
+    // time is the fast check, the content hash decides when it has changed
+    i64 m_source_mtime;
+    u64 m_source_size;
+    u64 m_source_hash;
+
+    // Hash of everything besides the source file that went into the vertex
+    // data (the vertex format, ...), chosen by the caller
+    u64 m_key;
+
+    // Object space bounds of the vertex data, which quantized vertex formats
+    // are relative to
+    f32 m_bounds_min[3];
+    f32 m_bounds_max[3];
+
+    // Object space bounding sphere as (center, radius), see
+    // compute_bounding_sphere
+    f32 m_bounding_sphere[4];
+  };
+
+  static_assert(sizeof(mesh_cache_header) == 96);
+  static_assert(sizeof(mesh_lod) == 12);
+
+  u64 hash_bytes (const void*, u64, u64 = 0xcbf29ce484222325ull);
+
+  class mesh_cache {
+    private:
+      mapped_file m_file;
+      const mesh_cache_header *m_header;
+
+    public:
+      mesh_cache ();
+      mesh_cache (mesh_cache&&) noexcept;
+      mesh_cache& operator = (mesh_cache&&) noexcept;
+      ~mesh_cache ();
+
+      mesh_cache (const mesh_cache&) = delete;
+      mesh_cache& operator = (const mesh_cache&) = delete;
+
+      // Maps the cache file belonging to the source and the key, and validates
+      // it against the source file, the vertex stride and the key. Returns
+      // false if the cache is missing or stale and has to be rebuilt with
+      // write().
+      bool open (const std::string&, u32, u64);
+
+      bool is_open () const;
+      const void* get_vertex_data () const;
+      u32 get_vertex_count () const;
+      u32 get_vertex_stride () const;
+      const u32* get_index_data () const;
+      u32 get_index_count () const;
+      bounding_box get_bounds () const;
+      glm::vec4 get_bounding_sphere () const;
+      std::vector <mesh_lod> get_lods () const;
+
+      // Writes the cache file for the source and the key, replacing any stale
+      // one
+      static bool write (const std::string&, u64, const void*, u32, u32, const u32*, u32, const bounding_box&, const glm::vec4&, const std::vector <mesh_lod>&);
+
+      // One file per key next to the source, so the same source built with
+      // different keys does not keep overwriting a single cache
+      static std::string get_cache_path (const std::string&, u64);
+  };
+
+} // namespace gl
+
+#endif // HEADER_MESH_MESH_CACHE_H
@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <numeric>
+
+#include "mesh_optimizer.hpp"
+
+namespace gl {
+
+  static constexpr u32 no_vertex = ~0u;
+
+  // FIFO vertex cache simulated with timestamps: a vertex is cached while
+  // fewer than `size` misses happened since it was inserted
+  struct fifo_cache {
+    std::vector <u32> m_timestamps;
+    u32 m_time;
+    u32 m_size;
+
+    fifo_cache (u32, u32);
+
+    bool contains (u32) const;
+    bool access (u32);
+    void flush ();
+  };
+
+  // Triangles of a mesh grouped by vertex (compressed rows)
+  struct vertex_triangles {
+    std::vector <u32> m_offsets;
+    std::vector <u32> m_triangles;
+
+    vertex_triangles (const std::vector <u32>&, u32);
+  };
+
+  static std::vector <u32> cluster_triangles (const std::vector <u32>&, u32, f32, u32);
+
+  fifo_cache::fifo_cache (u32 vertex_count, u32 size)
+    : m_timestamps (vertex_count, 0),
+      m_time (size + 1),
+      m_size (size) {
+
+  }
+
+  bool fifo_cache::contains (u32 v) const {
+    return m_time - m_timestamps[v] <= m_size;
+  }
+
+  // Returns true on a miss
+  bool fifo_cache::access (u32 v) {
+    if (contains(v))
+      return false;
+
+    m_timestamps[v] = m_time++;
+    return true;
+  }
+
+  void fifo_cache::flush () {
+    m_time += m_size + 1;
+  }
+
+  vertex_triangles::vertex_triangles (const std::vector <u32> &indices, u32 vertex_count)
+    : m_offsets (vertex_count + 1, 0),
+      m_triangles (indices.size()) {
+
+    for (u32 v: indices)
+      ++m_offsets[v + 1];
+
+    std::partial_sum(m_offsets.begin(), m_offsets.end(), m_offsets.begin());
+
+    std::vector <u32> cursor (m_offsets.begin(), m_offsets.end() - 1);
+
+    for (u64 i = 0; i < indices.size(); ++i)
+      m_triangles[cursor[indices[i]]++] = i / 3;
+  }
+
+  vertex_cache_statistics analyze_vertex_cache (const std::vector <u32> &indices, u32 vertex_count, u32 cache_size) {
+    fifo_cache cache (vertex_count, cache_size);
+    std::vector <bool> used (vertex_count, false);
+    u64 misses = 0;
+    u64 used_count = 0;
+
+    for (u32 v: indices) {
+      misses += cache.access(v);
+
+      if (not used[v]) {
+        used[v] = true;
+        ++used_count;
+      }
+    }
+
+    vertex_cache_statistics statistics = {0.0f, 0.0f};
+
+    if (indices.size() >= 3) {
+      statistics.m_acmr = static_cast <f32> (misses) / (indices.size() / 3);
+      statistics.m_atvr = static_cast <f32> (misses) / used_count;
+    }
+
+    return statistics;
+  }
+
+  // Fans around one vertex at a time, emitting all of its remaining
+  // triangles, then continues with the neighbour that is most recently cached
+  // and will still be cached once its own triangles are emitted. At a dead
+  // end it backtracks through recently used vertices, and only then moves on
+  // in input order
+  void optimize_vertex_cache (std::vector <u32> &indices, u32 vertex_count, u32 cache_size) {
+    u64 triangle_count = indices.size() / 3;
+
+    if (triangle_count == 0)
+      return;
+
+    vertex_triangles adjacency (indices, vertex_count);
+
+    // triangles of each vertex that are not emitted yet
+    std::vector <u32> live (vertex_count);
+
+    for (u32 v = 0; v < vertex_count; ++v)
+      live[v] = adjacency.m_offsets[v + 1] - adjacency.m_offsets[v];
+
+    fifo_cache cache (vertex_count, cache_size);
+    std::vector <bool> emitted (triangle_count, false);
+    std::vector <u32> dead_ends;
+    std::vector <u32> candidates;
+    std::vector <u32> output;
+    u32 scan = 0;
+
+    output.reserve(indices.size());
+
+    auto skip_dead_end = [&] () -> u32 {
+      while (not dead_ends.empty()) {
+        u32 v = dead_ends.back();
+        dead_ends.pop_back();
+
+        if (live[v] > 0)
+          return v;
+      }
+
+      for (; scan < vertex_count; ++scan)
+        if (live[scan] > 0)
+          return scan;
+
+      return no_vertex;
+    };
+
+    u32 fanning = skip_dead_end();
+
+    while (fanning != no_vertex) {
+      candidates.clear();
+
+      for (u32 k = adjacency.m_offsets[fanning]; k < adjacency.m_offsets[fanning + 1]; ++k) {
+        u32 t = adjacency.m_triangles[k];
+
+        if (emitted[t])
+          continue;
+
+        emitted[t] = true;
+
+        for (u32 c = 0; c < 3; ++c) {
+          u32 v = indices[3 * t + c];
+
+          output.push_back(v);
+          dead_ends.push_back(v);
+          candidates.push_back(v);
+
+          --live[v];
+          cache.access(v);
+        }
+      }
+
+      u32 next = no_vertex;
+      i64 best_priority = -1;
+
+      for (u32 v: candidates) {
+        if (live[v] == 0)
+          continue;
+
+        // Emitting the rest of v's triangles causes at most 2 misses each, if
+        // v survives that in the cache, prefer the one cached the longest
+        i64 age = cache.m_time - cache.m_timestamps[v];
+        i64 priority = age + 2 * live[v] <= cache_size ? age : 0;
+
+        if (priority > best_priority) {
+          best_priority = priority;
+          next = v;
+        }
+      }
+
+      fanning = next != no_vertex ? next : skip_dead_end();
+    }
+
+    indices.swap(output);
+  }
+
+  void optimize_overdraw (std::vector <u32> &indices, const std::vector <glm::vec3> &positions, f32 threshold, u32 cache_size) {
+    u64 triangle_count = indices.size() / 3;
+
+    if (triangle_count < 2)
+      return;
+
+    std::vector <u32> clusters = cluster_triangles(indices, positions.size(), threshold, cache_size);
+    u64 cluster_count = clusters.size() - 1;
+
+    if (cluster_count < 2)
+      return;
+
+    // Area weighted centroid and normal of every cluster
+    std::vector <glm::vec3> centroids (cluster_count, glm::vec3(0.0f));
+    std::vector <glm::vec3> normals (cluster_count, glm::vec3(0.0f));
+    glm::vec3 mesh_centroid (0.0f);
+    f32 mesh_area = 0.0f;
+
+    for (u64 c = 0; c < cluster_count; ++c) {
+      f32 area = 0.0f;
+
+      for (u64 t = clusters[c]; t < clusters[c + 1]; ++t) {
+        const glm::vec3 &a = positions[indices[3 * t + 0]];
+        const glm::vec3 &b = positions[indices[3 * t + 1]];
+        const glm::vec3 &d = positions[indices[3 * t + 2]];
+
+        glm::vec3 normal = glm::cross(b - a, d - a);
+        f32 triangle_area = glm::length(normal);
+
+        centroids[c] += (a + b + d) * (triangle_area / 3.0f);
+        normals[c] += normal;
+        area += triangle_area;
+      }
+
+      mesh_centroid += centroids[c];
+      mesh_area += area;
+
+      centroids[c] /= area > 0.0f ? area : 1.0f;
+    }
+
+    mesh_centroid /= mesh_area > 0.0f ? mesh_area : 1.0f;
+
+    // Clusters facing away from the center are more likely to be in front of
+    // the rest of the mesh, so they are drawn first
+    std::vector <f32> keys (cluster_count);
+
+    for (u64 c = 0; c < cluster_count; ++c) {
+      f32 length = glm::length(normals[c]);
+      keys[c] = length > 0.0f ? glm::dot(centroids[c] - mesh_centroid, normals[c] / length) : 0.0f;
+    }
+
+    std::vector <u32> order (cluster_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&keys] (u32 a, u32 b) { return keys[a] > keys[b]; });
+
+    std::vector <u32> output;
+    output.reserve(indices.size());
+
+    for (u32 c: order)
+      output.insert(output.end(), indices.begin() + 3 * clusters[c], indices.begin() + 3 * clusters[c + 1]);
+
+    indices.swap(output);
+  }
+
+  u32 optimize_vertex_fetch (std::vector <u32> &indices, u32 vertex_count, std::vector <u32> &remap) {
+    u32 next = 0;
+
+    remap.assign(vertex_count, no_vertex);
+
+    for (u32 &v: indices) {
+      if (remap[v] == no_vertex)
+        remap[v] = next++;
+
+      v = remap[v];
+    }
+
+    return next;
+  }
+
+  void optimize_mesh (obj_mesh &mesh, f32 overdraw_threshold) {
+    u32 vertex_count = mesh.m_positions.size();
+    std::vector <u32> remap;
+
+    optimize_vertex_cache(mesh.m_indices, vertex_count);
+    optimize_overdraw(mesh.m_indices, mesh.m_positions, overdraw_threshold);
+
+    vertex_count = optimize_vertex_fetch(mesh.m_indices, vertex_count, remap);
+
+    remap_vertices(mesh.m_positions, remap, vertex_count);
+
+    if (not mesh.m_texcoords.empty())
+      remap_vertices(mesh.m_texcoords, remap, vertex_count);
+
+    if (not mesh.m_normals.empty())
+      remap_vertices(mesh.m_normals, remap, vertex_count);
+  }
+
+  // Returns the first triangle of every cluster, followed by the triangle
+  // count. Hard boundaries are where the cache flushes (a triangle misses on
+  // all three vertices), soft ones split a run as soon as the ACMR of the
+  // part before it is within the threshold of the whole run's
+  std::vector <u32> cluster_triangles (const std::vector <u32> &indices, u32 vertex_count, f32 threshold, u32 cache_size) {
+    u64 triangle_count = indices.size() / 3;
+    fifo_cache cache (vertex_count, cache_size);
+    std::vector <u32> hard;
+    std::vector <u32> misses (triangle_count);
+
+    for (u64 t = 0; t < triangle_count; ++t) {
+      misses[t] = cache.access(indices[3 * t + 0]) + cache.access(indices[3 * t + 1]) + cache.access(indices[3 * t + 2]);
+
+      if (t == 0 or misses[t] == 3)
+        hard.push_back(t);
+    }
+
+    hard.push_back(triangle_count);
+
+    std::vector <u32> clusters;
+
+    for (u64 h = 0; h + 1 < hard.size(); ++h) {
+      u32 begin = hard[h];
+      u32 end = hard[h + 1];
+
+      u64 run_misses = 0;
+
+      for (u32 t = begin; t < end; ++t)
+        run_misses += misses[t];
+
+      f32 target = threshold * run_misses / (end - begin);
+
+      u32 start = begin;
+      u64 cluster_misses = 0;
+
+      clusters.push_back(begin);
+      cache.flush();
+
+      for (u32 t = begin; t < end; ++t) {
+        cluster_misses += cache.access(indices[3 * t + 0]) + cache.access(indices[3 * t + 1]) + cache.access(indices[3 * t + 2]);
+
+        if (t + 1 < end and cluster_misses <= target * (t - start + 1)) {
+          clusters.push_back(t + 1);
+          start = t + 1;
+          cluster_misses = 0;
+          cache.flush();
+        }
+      }
+    }
+
+    clusters.push_back(triangle_count);
+
+    return clusters;
+  }
+
+} // namespace gl
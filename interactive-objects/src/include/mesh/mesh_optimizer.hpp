@@ -0,0 +1,65 @@
+#ifndef HEADER_MESH_MESH_OPTIMIZER_H
+#define HEADER_MESH_MESH_OPTIMIZER_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "types.hpp"
+#include "obj_loader.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // Post-transform vertex cache model used by the optimizer and the
+  // statistics: a FIFO of this many vertices, which is close to what most
+  // desktop GPUs behave like
+  const u32 default_vertex_cache_size = 16;
+
+  struct vertex_cache_statistics {
+    // Average cache miss ratio, vertex shader invocations per triangle. 3 is
+    // the worst case, about 0.5 the best a regular grid can do
+    f32 m_acmr;
+
+    // Average transformed vertex ratio, vertex shader invocations per vertex.
+    // 1 means every vertex is transformed exactly once
+    f32 m_atvr;
+  };
+
+  vertex_cache_statistics analyze_vertex_cache (const std::vector <u32>&, u32, u32 = default_vertex_cache_size);
+
+  // Reorders the triangles for the post-transform vertex cache (Tipsify, Sander
+  // et al. 2007). Runs in linear time
+  void optimize_vertex_cache (std::vector <u32>&, u32, u32 = default_vertex_cache_size);
+
+  // Reorders clusters of triangles so that outward facing ones come first,
+  // which lets early depth testing reject more of what is drawn behind them.
+  // Expects a cache optimized index buffer: it is cut into clusters wherever
+  // the cache flushes, and those are only split further while the ACMR
+  // stays within `threshold` times its current value
+  void optimize_overdraw (std::vector <u32>&, const std::vector <glm::vec3>&, f32 = 1.05f, u32 = default_vertex_cache_size);
+
+  // Renumbers the vertices in the order the index buffer first uses them so
+  // vertex fetches walk memory forward. Fills `remap` (old vertex to new
+  // vertex, ~0u for unused ones) and returns the new vertex count
+  u32 optimize_vertex_fetch (std::vector <u32>&, u32, std::vector <u32>&);
+
+  // Applies a remap from optimize_vertex_fetch to a vertex attribute array
+  template <typename vertex_type>
+  void remap_vertices (std::vector <vertex_type> &vertices, const std::vector <u32> &remap, u32 vertex_count) {
+    std::vector <vertex_type> remapped (vertex_count);
+
+    for (u64 i = 0; i < vertices.size(); ++i)
+      if (remap[i] != ~0u)
+        remapped[remap[i]] = vertices[i];
+
+    vertices.swap(remapped);
+  }
+
+  // Runs the three passes above on a loaded mesh, in that order
+  void optimize_mesh (obj_mesh&, f32 = 1.05f);
+
+} // namespace gl
+
+#endif // HEADER_MESH_MESH_OPTIMIZER_H
@@ -0,0 +1,328 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_set>
+
+#include "bounds.hpp"
+#include "mesh_optimizer.hpp"
+#include "mesh_simplifier.hpp"
+
+namespace gl {
+
+  // Sum of squared distances to a set of planes, Q(p) = p'Ap + 2b'p + c with
+  // the symmetric A stored as its upper triangle
+  struct quadric {
+    f32 m_a00 = 0.0f;
+    f32 m_a11 = 0.0f;
+    f32 m_a22 = 0.0f;
+    f32 m_a01 = 0.0f;
+    f32 m_a02 = 0.0f;
+    f32 m_a12 = 0.0f;
+    f32 m_b0 = 0.0f;
+    f32 m_b1 = 0.0f;
+    f32 m_b2 = 0.0f;
+    f32 m_c = 0.0f;
+
+    void add_plane (const glm::vec3&, f32, f32);
+    void add (const quadric&);
+    f32 evaluate (const glm::vec3&) const;
+  };
+
+  struct edge_collapse {
+    u32 m_from;
+    u32 m_to;
+    f32 m_cost;
+  };
+
+  // How much more moving a border costs than moving a surface, keeps the
+  // silhouette of open meshes intact
+  static constexpr f32 border_weight = 10.0f;
+
+  // Levels with fewer triangles are not worth the extra index data
+  static constexpr u32 min_lod_triangles = 16;
+
+  static bool collapse_flips (const std::vector <u32>&, const std::vector <glm::vec3>&, const std::vector <u32>&, const std::vector <u32>&, u32, u32);
+
+  void quadric::add_plane (const glm::vec3 &n, f32 d, f32 weight) {
+    m_a00 += weight * n.x * n.x;
+    m_a11 += weight * n.y * n.y;
+    m_a22 += weight * n.z * n.z;
+    m_a01 += weight * n.x * n.y;
+    m_a02 += weight * n.x * n.z;
+    m_a12 += weight * n.y * n.z;
+    m_b0 += weight * n.x * d;
+    m_b1 += weight * n.y * d;
+    m_b2 += weight * n.z * d;
+    m_c += weight * d * d;
+  }
+
+  void quadric::add (const quadric &q) {
+    m_a00 += q.m_a00;
+    m_a11 += q.m_a11;
+    m_a22 += q.m_a22;
+    m_a01 += q.m_a01;
+    m_a02 += q.m_a02;
+    m_a12 += q.m_a12;
+    m_b0 += q.m_b0;
+    m_b1 += q.m_b1;
+    m_b2 += q.m_b2;
+    m_c += q.m_c;
+  }
+
+  f32 quadric::evaluate (const glm::vec3 &p) const {
+    f32 rx = m_a00 * p.x + m_a01 * p.y + m_a02 * p.z;
+    f32 ry = m_a01 * p.x + m_a11 * p.y + m_a12 * p.z;
+    f32 rz = m_a02 * p.x + m_a12 * p.y + m_a22 * p.z;
+
+    f32 error = rx * p.x + ry * p.y + rz * p.z + 2.0f * (m_b0 * p.x + m_b1 * p.y + m_b2 * p.z) + m_c;
+
+    // rounding can take a perfect fit slightly below zero
+    return std::max(error, 0.0f);
+  }
+
+  f32 simplify_mesh (const std::vector <u32> &indices, const std::vector <glm::vec3> &positions, u32 target, std::vector <u32> &result) {
+    result = indices;
+
+    u32 vertex_count = positions.size();
+    bounding_box bounds = compute_bounds(positions);
+    glm::vec3 size = bounds.m_max - bounds.m_min;
+    f32 scale = std::max({size.x, size.y, size.z});
+
+    if (result.size() <= target or bounds.is_empty() or scale <= 0.0f)
+      return 0.0f;
+
+    // A unit sized copy keeps the quadrics well conditioned in single
+    // precision whatever the units of the mesh are
+    std::vector <glm::vec3> points (vertex_count);
+
+    for (u32 v = 0; v < vertex_count; ++v)
+      points[v] = (positions[v] - bounds.m_min) / scale;
+
+    auto edge_key = [] (u32 a, u32 b) {
+      return (static_cast <u64> (a) << 32) | b;
+    };
+
+    std::unordered_set <u64> half_edges;
+    half_edges.reserve(result.size());
+
+    for (u64 t = 0; t < result.size(); t += 3)
+      for (u32 e = 0; e < 3; ++e)
+        half_edges.insert(edge_key(result[t + e], result[t + (e + 1) % 3]));
+
+    // Every vertex starts with the planes of its triangles. A half edge
+    // without its twin is a border, which adds a plane perpendicular to the
+    // surface along it
+    std::vector <quadric> quadrics (vertex_count);
+    std::vector <bool> border (vertex_count, false);
+
+    for (u64 t = 0; t < result.size(); t += 3) {
+      const glm::vec3 &a = points[result[t + 0]];
+      glm::vec3 normal = glm::cross(points[result[t + 1]] - a, points[result[t + 2]] - a);
+      f32 length = glm::length(normal);
+
+      if (length == 0.0f)
+        continue;
+
+      normal /= length;
+
+      for (u32 c = 0; c < 3; ++c)
+        quadrics[result[t + c]].add_plane(normal, -glm::dot(normal, a), 1.0f);
+
+      for (u32 e = 0; e < 3; ++e) {
+        u32 u = result[t + e];
+        u32 w = result[t + (e + 1) % 3];
+
+        if (half_edges.contains(edge_key(w, u)))
+          continue;
+
+        border[u] = border[w] = true;
+
+        glm::vec3 side = glm::cross(points[w] - points[u], normal);
+        f32 side_length = glm::length(side);
+
+        if (side_length == 0.0f)
+          continue;
+
+        side /= side_length;
+        quadrics[u].add_plane(side, -glm::dot(side, points[u]), border_weight);
+        quadrics[w].add_plane(side, -glm::dot(side, points[u]), border_weight);
+      }
+    }
+
+    std::vector <u32> offsets;
+    std::vector <u32> triangles;
+    std::vector <u32> remap (vertex_count);
+    std::vector <bool> locked (vertex_count);
+    std::vector <edge_collapse> collapses;
+    f32 max_cost = 0.0f;
+
+    // Each pass collapses the cheapest edges it can without two collapses
+    // touching the same neighbourhood, then rebuilds the triangle list
+    while (result.size() > target) {
+      offsets.assign(vertex_count + 1, 0);
+
+      for (u32 v: result)
+        ++offsets[v + 1];
+
+      std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+      triangles.resize(result.size());
+
+      {
+        std::vector <u32> cursor (offsets.begin(), offsets.end() - 1);
+
+        for (u64 i = 0; i < result.size(); ++i)
+          triangles[cursor[result[i]]++] = i / 3;
+      }
+
+      collapses.clear();
+
+      for (u64 t = 0; t < result.size(); t += 3) {
+        for (u32 e = 0; e < 3; ++e) {
+          u32 from = result[t + e];
+          u32 to = result[t + (e + 1) % 3];
+
+          // a border vertex may only slide along the border
+          if (border[from] and not border[to])
+            continue;
+
+          f32 cost = quadrics[from].evaluate(points[to]) + quadrics[to].evaluate(points[to]);
+          collapses.push_back({from, to, cost});
+        }
+      }
+
+      std::sort(collapses.begin(), collapses.end(), [] (const edge_collapse &a, const edge_collapse &b) {
+        return a.m_cost < b.m_cost;
+      });
+
+      std::iota(remap.begin(), remap.end(), 0);
+      std::fill(locked.begin(), locked.end(), false);
+
+      u64 goal = (result.size() - target) / 3;
+      u64 removed = 0;
+      u32 performed = 0;
+
+      if (collapses.empty())
+        break;
+
+      // A collapse removes about two triangles, so the goal is reached around
+      // the goal / 2 cheapest ones. Whatever the locks leave out waits for the
+      // next pass instead of being replaced by far more expensive collapses
+      f32 pass_limit = 1.5f * collapses[std::min <u64> (goal / 2, collapses.size() - 1)].m_cost;
+
+      for (auto &collapse: collapses) {
+        if (removed >= goal or collapse.m_cost > pass_limit)
+          break;
+
+        u32 from = collapse.m_from;
+        u32 to = collapse.m_to;
+
+        if (locked[from] or locked[to] or collapse_flips(result, points, offsets, triangles, from, to))
+          continue;
+
+        // Nothing around `from` may move for the rest of the pass, the flip
+        // test above relied on it
+        for (u32 k = offsets[from]; k < offsets[from + 1]; ++k) {
+          u64 t = 3 * static_cast <u64> (triangles[k]);
+
+          removed += result[t] == to or result[t + 1] == to or result[t + 2] == to;
+
+          for (u32 c = 0; c < 3; ++c)
+            locked[result[t + c]] = true;
+        }
+
+        remap[from] = to;
+        quadrics[to].add(quadrics[from]);
+        max_cost = std::max(max_cost, collapse.m_cost);
+        ++performed;
+      }
+
+      if (performed == 0)
+        break;
+
+      u64 write = 0;
+
+      for (u64 t = 0; t < result.size(); t += 3) {
+        u32 a = remap[result[t + 0]];
+        u32 b = remap[result[t + 1]];
+        u32 c = remap[result[t + 2]];
+
+        if (a == b or b == c or a == c)
+          continue;
+
+        result[write++] = a;
+        result[write++] = b;
+        result[write++] = c;
+      }
+
+      result.resize(write);
+    }
+
+    return std::sqrt(max_cost) * scale;
+  }
+
+  std::vector <mesh_lod> build_lod_chain (std::vector <u32> &indices, const std::vector <glm::vec3> &positions, u32 max_levels, f32 ratio) {
+    std::vector <mesh_lod> lods;
+    lods.push_back({0, static_cast <u32> (indices.size()), 0.0f});
+
+    f32 radius = glm::length(compute_bounds(positions).get_extent());
+    std::vector <u32> previous (indices);
+    std::vector <u32> simplified;
+    f32 error = 0.0f;
+
+    for (u32 level = 1; level <= max_levels; ++level) {
+      u32 target = static_cast <u32> (previous.size() / 3 * ratio) * 3;
+
+      if (target < 3 * min_lod_triangles)
+        break;
+
+      f32 level_error = simplify_mesh(previous, positions, target, simplified);
+
+      // Stuck well short of the target, the mesh has no more detail to spare
+      if (simplified.size() > (previous.size() + target) / 2)
+        break;
+
+      // Each level is simplified from the previous one, the errors add up
+      error += level_error;
+
+      optimize_vertex_cache(simplified, positions.size());
+
+      lods.push_back({static_cast <u32> (indices.size()), static_cast <u32> (simplified.size()), radius > 0.0f ? error / radius : 0.0f});
+      indices.insert(indices.end(), simplified.begin(), simplified.end());
+      previous.swap(simplified);
+    }
+
+    return lods;
+  }
+
+  // Whether collapsing `from` onto `to` turns any of the triangles around
+  // `from` that survive the collapse upside down
+  bool collapse_flips (
+    const std::vector <u32> &indices, const std::vector <glm::vec3> &points,
+    const std::vector <u32> &offsets, const std::vector <u32> &triangles,
+    u32 from, u32 to
+  ) {
+    for (u32 k = offsets[from]; k < offsets[from + 1]; ++k) {
+      const u32 *triangle = &indices[3 * static_cast <u64> (triangles[k])];
+
+      if (triangle[0] == to or triangle[1] == to or triangle[2] == to)
+        continue;
+
+      glm::vec3 before[3];
+      glm::vec3 after[3];
+
+      for (u32 c = 0; c < 3; ++c) {
+        before[c] = points[triangle[c]];
+        after[c] = triangle[c] == from ? points[to] : before[c];
+      }
+
+      glm::vec3 normal_before = glm::cross(before[1] - before[0], before[2] - before[0]);
+      glm::vec3 normal_after = glm::cross(after[1] - after[0], after[2] - after[0]);
+
+      if (glm::dot(normal_before, normal_after) <= 1e-2f * glm::length(normal_before) * glm::length(normal_after))
+        return true;
+    }
+
+    return false;
+  }
+
+} // namespace gl
@@ -0,0 +1,41 @@
+#ifndef HEADER_MESH_MESH_SIMPLIFIER_H
+#define HEADER_MESH_MESH_SIMPLIFIER_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "types.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // One level of detail: a range of a shared index buffer. All levels of a
+  // mesh index the same vertices
+  struct mesh_lod {
+    u32 m_index_offset;
+    u32 m_index_count;
+
+    // Geometric deviation from the full detail mesh, relative to the radius
+    // of the mesh bounding sphere. 0 for the full detail level
+    f32 m_error;
+  };
+
+  // Quadric error edge collapse (Garland and Heckbert 1997). Vertices are
+  // collapsed onto one of their neighbours, never moved, so the result indexes
+  // the same vertex buffer. Border edges are kept in place. Writes the
+  // triangles of the simplified mesh, at most `target` indices unless the
+  // mesh cannot be simplified that far, and returns the error in object
+  // space units
+  f32 simplify_mesh (const std::vector <u32>&, const std::vector <glm::vec3>&, u32, std::vector <u32>&);
+
+  // Appends up to `max_levels` coarser levels to the index buffer, each with
+  // about `ratio` times the triangles of the previous one, and returns every
+  // level, the full detail one first. Stops early once a mesh no longer
+  // simplifies
+  std::vector <mesh_lod> build_lod_chain (std::vector <u32>&, const std::vector <glm::vec3>&, u32 = 4, f32 = 0.5f);
+
+} // namespace gl
+
+#endif // HEADER_MESH_MESH_SIMPLIFIER_H
@@ -0,0 +1,523 @@
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+#include "mapped_file.hpp"
+#include "obj_loader.hpp"
+
+namespace gl {
+
+  // Below this much text per chunk, spawning jobs costs more than it saves
+  static constexpr u64 min_chunk_size = 256 * 1024;
+
+  // Marks an attribute a face corner does not reference
+  static constexpr u32 no_index = ~0u;
+
+  // Raw records of (a chunk of) an OBJ file
+  struct obj_records {
+    std::vector <glm::vec3> m_positions;
+    std::vector <glm::vec2> m_texcoords;
+    std::vector <glm::vec3> m_normals;
+
+    // Triangulated face corners, one array per attribute (v, vt, vn), as
+    // 0-based indices into the records of the whole file. The texcoord and
+    // normal arrays stay empty unless those attributes are requested
+    std::vector <u32> m_corners[3];
+
+    // Per attribute, the slots of m_corners holding a relative index. Those
+    // are resolved against the chunk's own record count and still need the
+    // number of records in the preceding chunks added once chunks are merged
+    std::vector <u32> m_relative_slots[3];
+
+    u32 m_face_records = 0;
+    u32 m_polygon_records = 0;
+    u32 m_skipped_faces = 0;
+
+    void reserve (u64, u32);
+  };
+
+  static void parse_records (const char*, const char*, obj_records&, u32);
+  static void build_mesh (obj_records&, obj_mesh&, u32);
+  static bool parse_corner (const char*&, const char*, const obj_records&, u32, u32*, bool*);
+  static bool resolve_index (i64, u64, u32&, bool&);
+  static u32 hash_corner (u32, u32, u32);
+
+  static const char* skip_spaces (const char*, const char*);
+  static const char* next_line (const char*, const char*);
+  static const char* parse_f32 (const char*, const char*, f32&);
+  static const char* parse_i64 (const char*, const char*, i64&);
+
+  static const u32 attribute_bits[3] = {obj_attribute::position, obj_attribute::texcoord, obj_attribute::normal};
+
+  void obj_mesh::clear () {
+    m_positions.clear();
+    m_texcoords.clear();
+    m_normals.clear();
+    m_indices.clear();
+    m_statistics = {};
+  }
+
+  void obj_records::reserve (u64 bytes, u32 attributes) {
+    // A blender export averages ~30 bytes per record, which is close enough to
+    // avoid most of the reallocations without a counting pass
+    m_positions.reserve(bytes / 64);
+
+    for (u32 a = 0; a < 3; ++a)
+      if (a == 0 or (attributes & attribute_bits[a]))
+        m_corners[a].reserve(bytes / 16);
+  }
+
+  void parse_obj (const char *begin, const char *end, obj_mesh &mesh, u32 attributes) {
+    obj_records records;
+
+    records.reserve(end - begin, attributes);
+    parse_records(begin, end, records, attributes);
+    build_mesh(records, mesh, attributes);
+  }
+
+  bool load_obj (const std::string &filepath, obj_mesh &mesh, u32 attributes, job_system *jobs) {
+    mesh.clear();
+
+    mapped_file file;
+
+    if (not file.open(filepath))
+      return false;
+
+    const char *begin = file.get_data();
+    const char *end = begin + file.get_size();
+
+    u32 thread_count = jobs != nullptr ? jobs->get_thread_count() : 1;
+    u32 chunk_count = std::clamp <u64> (file.get_size() / min_chunk_size, 1, thread_count);
+
+    if (chunk_count == 1) {
+      parse_obj(begin, end, mesh, attributes);
+      return true;
+    }
+
+    // Every chunk starts at the beginning of a line, so no record is split
+    // between two chunks
+    std::vector <const char*> bounds (chunk_count + 1, end);
+    bounds[0] = begin;
+
+    for (u32 i = 1; i < chunk_count; ++i) {
+      const char *split = std::max(begin + file.get_size() * i / chunk_count, bounds[i - 1]);
+      bounds[i] = next_line(split, end);
+    }
+
+    struct offsets {
+      u64 m_records[3] = {0, 0, 0};
+      u64 m_corners[3] = {0, 0, 0};
+    };
+
+    obj_records records;
+    std::vector <obj_records> chunks (chunk_count);
+    std::vector <offsets> chunk_offsets (chunk_count + 1);
+
+    auto parse = [&] (u32 first, u32 last) {
+      for (u32 i = first; i < last; ++i) {
+        chunks[i].reserve(bounds[i + 1] - bounds[i], attributes);
+        parse_records(bounds[i], bounds[i + 1], chunks[i], attributes);
+      }
+    };
+
+    jobs->parallel_for(0, chunk_count, 1, parse);
+
+    // Once every chunk is parsed: lay the chunks out back to back in file
+    // order so each job knows where to copy its own records
+    {
+      for (u32 i = 0; i < chunk_count; ++i) {
+        auto &chunk = chunks[i];
+        const u64 record_counts[3] = {chunk.m_positions.size(), chunk.m_texcoords.size(), chunk.m_normals.size()};
+
+        for (u32 a = 0; a < 3; ++a) {
+          chunk_offsets[i + 1].m_records[a] = chunk_offsets[i].m_records[a] + record_counts[a];
+          chunk_offsets[i + 1].m_corners[a] = chunk_offsets[i].m_corners[a] + chunk.m_corners[a].size();
+        }
+
+        records.m_face_records += chunk.m_face_records;
+        records.m_polygon_records += chunk.m_polygon_records;
+        records.m_skipped_faces += chunk.m_skipped_faces;
+      }
+
+      auto &total = chunk_offsets[chunk_count];
+
+      records.m_positions.resize(total.m_records[0]);
+      records.m_texcoords.resize(total.m_records[1]);
+      records.m_normals.resize(total.m_records[2]);
+
+      for (u32 a = 0; a < 3; ++a)
+        records.m_corners[a].resize(total.m_corners[a]);
+    }
+
+    auto copy = [&] (u32 i) {
+      obj_records &chunk = chunks[i];
+      const offsets &offset = chunk_offsets[i];
+
+      std::copy(chunk.m_positions.begin(), chunk.m_positions.end(), records.m_positions.begin() + offset.m_records[0]);
+      std::copy(chunk.m_texcoords.begin(), chunk.m_texcoords.end(), records.m_texcoords.begin() + offset.m_records[1]);
+      std::copy(chunk.m_normals.begin(), chunk.m_normals.end(), records.m_normals.begin() + offset.m_records[2]);
+
+      for (u32 a = 0; a < 3; ++a) {
+        // Relative indices only know their position within the chunk, rebase
+        // them onto the records of all preceding chunks. Absolute indices are
+        // global to the file already
+        for (u32 slot: chunk.m_relative_slots[a])
+          chunk.m_corners[a][slot] += static_cast <u32> (offset.m_records[a]);
+
+        std::copy(chunk.m_corners[a].begin(), chunk.m_corners[a].end(), records.m_corners[a].begin() + offset.m_corners[a]);
+      }
+
+      chunk = obj_records();
+    };
+
+    jobs->parallel_for(0, chunk_count, 1, [&] (u32 first, u32 last) {
+      for (u32 i = first; i < last; ++i)
+        copy(i);
+    });
+
+    build_mesh(records, mesh, attributes);
+
+    return true;
+  }
+
+  // Records and indices of attributes that were not requested are skipped
+  // entirely, they would only be thrown away by build_mesh
+  void parse_records (const char *begin, const char *end, obj_records &records, u32 attributes) {
+    const char *p = begin;
+
+    while (p < end) {
+      const char *line = skip_spaces(p, end);
+      const char *eol = next_line(line, end);
+
+      p = eol;
+
+      if (end - line < 2)
+        continue;
+
+      if (line[0] == 'v' and (line[1] == ' ' or line[1] == '\t')) {
+        glm::vec3 v;
+        const char *q = line + 2;
+
+        if ((q = parse_f32(q, eol, v.x)) and
+            (q = parse_f32(q, eol, v.y)) and
+            (q = parse_f32(q, eol, v.z)))
+          records.m_positions.push_back(v);
+      }
+      else if (line[0] == 'v' and line[1] == 't' and (attributes & obj_attribute::texcoord)) {
+        glm::vec2 vt (0.0f);
+        const char *q = parse_f32(line + 2, eol, vt.x);
+
+        // the second coordinate is optional
+        if (q != nullptr) {
+          parse_f32(q, eol, vt.y);
+          records.m_texcoords.push_back(vt);
+        }
+      }
+      else if (line[0] == 'v' and line[1] == 'n' and (attributes & obj_attribute::normal)) {
+        glm::vec3 vn;
+        const char *q = line + 2;
+
+        if ((q = parse_f32(q, eol, vn.x)) and
+            (q = parse_f32(q, eol, vn.y)) and
+            (q = parse_f32(q, eol, vn.z)))
+          records.m_normals.push_back(vn);
+      }
+      else if (line[0] == 'f' and (line[1] == ' ' or line[1] == '\t')) {
+        const char *q = line + 2;
+        u64 corners_begin[3];
+        u64 relative_begin[3];
+
+        for (u32 a = 0; a < 3; ++a) {
+          corners_begin[a] = records.m_corners[a].size();
+          relative_begin[a] = records.m_relative_slots[a].size();
+        }
+
+        // (v, vt, vn) of the first, previous and current corner, with a flag
+        // per index telling if it was relative
+        u32 corners[3][3];
+        bool relative[3][3];
+        u32 corner_count = 0;
+        bool valid = true;
+
+        auto push_corner = [&] (u32 c) {
+          for (u32 a = 0; a < 3; ++a) {
+            if (a > 0 and not (attributes & attribute_bits[a]))
+              continue;
+
+            if (relative[c][a])
+              records.m_relative_slots[a].push_back(records.m_corners[a].size());
+
+            records.m_corners[a].push_back(corners[c][a]);
+          }
+        };
+
+        ++records.m_face_records;
+
+        while ((q = skip_spaces(q, eol)) < eol and *q != '\n' and *q != '#') {
+          u32 current = std::min(corner_count, 2u);
+
+          if (not (valid = parse_corner(q, eol, records, attributes, corners[current], relative[current])))
+            break;
+
+          // Fan triangulation: from the third corner on, every corner forms a
+          // triangle with the first and the previous one
+          if (corner_count >= 2) {
+            push_corner(0);
+            push_corner(1);
+            push_corner(2);
+
+            std::copy(corners[2], corners[2] + 3, corners[1]);
+            std::copy(relative[2], relative[2] + 3, relative[1]);
+          }
+
+          ++corner_count;
+        }
+
+        if (not valid or corner_count < 3) {
+          for (u32 a = 0; a < 3; ++a) {
+            records.m_corners[a].resize(corners_begin[a]);
+            records.m_relative_slots[a].resize(relative_begin[a]);
+          }
+
+          ++records.m_skipped_faces;
+          continue;
+        }
+
+        if (corner_count > 3)
+          ++records.m_polygon_records;
+      }
+    }
+  }
+
+  void build_mesh (obj_records &records, obj_mesh &mesh, u32 attributes) {
+    mesh.clear();
+
+    bool use_texcoords = (attributes & obj_attribute::texcoord) and not records.m_texcoords.empty();
+    bool use_normals = (attributes & obj_attribute::normal) and not records.m_normals.empty();
+
+    const u32 *positions = records.m_corners[0].data();
+    const u32 *texcoords = records.m_corners[1].data();
+    const u32 *normals = records.m_corners[2].data();
+    u64 corner_count = records.m_corners[0].size();
+
+    // Open addressing hash map (linear probing) from a (v, vt, vn) key to the
+    // vertex built for it. At most one vertex per corner, so a power of two
+    // of at least twice the corner count keeps the load factor under 1/2.
+    // When only positions are used the position index is a perfect hash, and
+    // the table turns into a direct lookup by `v`
+    bool by_position = not use_texcoords and not use_normals;
+    u64 capacity = 16;
+
+    while (capacity < 2 * corner_count)
+      capacity <<= 1;
+
+    std::vector <u32> table (by_position ? records.m_positions.size() : capacity, no_index);
+    std::vector <u32> keys;
+
+    keys.reserve(3 * std::min <u64> (corner_count, records.m_positions.size() * 2));
+
+    auto find_or_insert = [&] (u32 v, u32 vt, u32 vn) -> u32 {
+      u64 slot = v;
+
+      if (not by_position) {
+        slot = hash_corner(v, vt, vn) & (capacity - 1);
+
+        while (table[slot] != no_index) {
+          const u32 *key = &keys[3 * table[slot]];
+
+          if (key[0] == v and key[1] == vt and key[2] == vn)
+            break;
+
+          slot = (slot + 1) & (capacity - 1);
+        }
+      }
+
+      if (table[slot] == no_index) {
+        table[slot] = keys.size() / 3;
+        keys.insert(keys.end(), {v, vt, vn});
+      }
+
+      return table[slot];
+    };
+
+    auto in_range = [] (u32 index, u64 count) {
+      return index == no_index or index < count;
+    };
+
+    // The vertex indices are written over the position corners, which are
+    // read at least as far ahead as they are written
+    u32 *indices = records.m_corners[0].data();
+    u64 index_count = 0;
+    u32 skipped = 0;
+
+    for (u64 t = 0; t < corner_count; t += 3) {
+      bool valid = true;
+
+      // Indices past the end of the file can only be checked now that all
+      // records (of all chunks) are known
+      for (u64 c = t; c < t + 3; ++c) {
+        valid = valid
+          and positions[c] < records.m_positions.size()
+          and (not use_texcoords or in_range(texcoords[c], records.m_texcoords.size()))
+          and (not use_normals or in_range(normals[c], records.m_normals.size()));
+      }
+
+      if (not valid) {
+        ++skipped;
+        continue;
+      }
+
+      for (u64 c = t; c < t + 3; ++c) {
+        indices[index_count++] = find_or_insert(
+          positions[c],
+          use_texcoords ? texcoords[c] : no_index,
+          use_normals ? normals[c] : no_index
+        );
+      }
+    }
+
+    u64 vertex_count = keys.size() / 3;
+
+    mesh.m_indices = std::move(records.m_corners[0]);
+    mesh.m_indices.resize(index_count);
+    mesh.m_positions.resize(vertex_count);
+
+    if (use_texcoords)
+      mesh.m_texcoords.resize(vertex_count, glm::vec2(0.0f));
+
+    if (use_normals)
+      mesh.m_normals.resize(vertex_count, glm::vec3(0.0f));
+
+    for (u64 i = 0; i < vertex_count; ++i) {
+      mesh.m_positions[i] = records.m_positions[keys[3 * i + 0]];
+
+      if (use_texcoords and keys[3 * i + 1] != no_index)
+        mesh.m_texcoords[i] = records.m_texcoords[keys[3 * i + 1]];
+
+      if (use_normals and keys[3 * i + 2] != no_index)
+        mesh.m_normals[i] = records.m_normals[keys[3 * i + 2]];
+    }
+
+    auto &statistics = mesh.m_statistics;
+
+    statistics.m_position_records = records.m_positions.size();
+    statistics.m_texcoord_records = records.m_texcoords.size();
+    statistics.m_normal_records = records.m_normals.size();
+    statistics.m_face_records = records.m_face_records;
+    statistics.m_polygon_records = records.m_polygon_records;
+    statistics.m_skipped_faces = records.m_skipped_faces + skipped;
+    statistics.m_corner_count = index_count;
+    statistics.m_vertex_count = vertex_count;
+  }
+
+  // Parses one `v`, `v/vt`, `v//vn` or `v/vt/vn` corner and advances p past it.
+  // Texture coordinate and normal indices that were not requested are skipped,
+  // not parsed
+  bool parse_corner (const char *&p, const char *end, const obj_records &records, u32 attributes, u32 *corner, bool *relative) {
+    const u64 counts[3] = {records.m_positions.size(), records.m_texcoords.size(), records.m_normals.size()};
+
+    auto is_separator = [end] (const char *q) {
+      return q == end or *q == ' ' or *q == '\t' or *q == '\r' or *q == '\n';
+    };
+
+    corner[0] = corner[1] = corner[2] = no_index;
+    relative[0] = relative[1] = relative[2] = false;
+
+    // not `corner[0] != no_index`: a relative index into a preceding chunk
+    // may resolve to that exact value before it is rebased
+    bool has_position = false;
+
+    for (u32 a = 0; a < 3 and not is_separator(p); ++a) {
+      if (a > 0) {
+        if (*p != '/')
+          return false;
+
+        ++p;
+      }
+
+      if (a > 0 and not (attributes & attribute_bits[a])) {
+        while (not is_separator(p) and *p != '/')
+          ++p;
+        continue;
+      }
+
+      // v//vn leaves out the texture coordinate
+      if (a == 1 and p < end and *p == '/')
+        continue;
+
+      i64 index;
+      const char *q = parse_i64(p, end, index);
+
+      if (q == nullptr or not resolve_index(index, counts[a], corner[a], relative[a]))
+        return false;
+
+      p = q;
+      has_position = true;
+    }
+
+    // a position is mandatory and anything else glued to the corner makes it
+    // malformed
+    return is_separator(p) and has_position;
+  }
+
+  // OBJ indices start at 1. Negative indices count back from the last record
+  // read so far (within the current chunk, see obj_records::m_relative_slots)
+  bool resolve_index (i64 index, u64 count, u32 &resolved, bool &relative) {
+    if (index > 0 and index <= no_index) {
+      resolved = static_cast <u32> (index - 1);
+      relative = false;
+      return true;
+    }
+
+    if (index < 0 and index >= -static_cast <i64> (no_index)) {
+      // may wrap around for references into a preceding chunk, rebasing
+      // wraps it back
+      resolved = static_cast <u32> (count + index);
+      relative = true;
+      return true;
+    }
+
+    return false;
+  }
+
+  u32 hash_corner (u32 v, u32 vt, u32 vn) {
+    u32 hash = v * 0x9e3779b1u;
+    hash ^= vt * 0x85ebca77u + (hash << 6) + (hash >> 2);
+    hash ^= vn * 0xc2b2ae3du + (hash << 6) + (hash >> 2);
+    hash ^= hash >> 15;
+    hash *= 0x2c1b3c6du;
+    hash ^= hash >> 12;
+    return hash;
+  }
+
+  const char* skip_spaces (const char *p, const char *end) {
+    while (p < end and (*p == ' ' or *p == '\t' or *p == '\r'))
+      ++p;
+    return p;
+  }
+
+  const char* next_line (const char *p, const char *end) {
+    const void *newline = std::memchr(p, '\n', end - p);
+    return newline == nullptr ? end : static_cast <const char*> (newline) + 1;
+  }
+
+  const char* parse_f32 (const char *p, const char *end, f32 &value) {
+    p = skip_spaces(p, end);
+
+    // from_chars does not accept an explicit plus sign
+    if (p < end and *p == '+')
+      ++p;
+
+    auto [ptr, ec] = std::from_chars(p, end, value);
+    return ec == std::errc() ? ptr : nullptr;
+  }
+
+  const char* parse_i64 (const char *p, const char *end, i64 &value) {
+    if (p < end and *p == '+')
+      ++p;
+
+    auto [ptr, ec] = std::from_chars(p, end, value);
+    return ec == std::errc() ? ptr : nullptr;
+  }
+
+} // namespace gl
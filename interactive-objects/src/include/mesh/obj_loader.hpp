@@ -0,0 +1,72 @@
+#ifndef HEADER_MESH_OBJ_LOADER_H
+#define HEADER_MESH_OBJ_LOADER_H
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "types.hpp"
+#include "job/job_system.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // Vertex attributes that can be requested from the loader. Positions are
+  // always loaded. Only requested attributes take part in vertex
+  // deduplication, so a mesh loaded with just positions gets one vertex per
+  // distinct `v` record no matter how many normals or texture coordinates the
+  // faces reference.
+  namespace obj_attribute {
+
+    const u32 position = 1 << 0;
+    const u32 texcoord = 1 << 1;
+    const u32 normal   = 1 << 2;
+    const u32 all      = position | texcoord | normal;
+
+  } // namespace obj_attribute
+
+  struct obj_statistics {
+    u32 m_position_records;
+    u32 m_texcoord_records;
+    u32 m_normal_records;
+    u32 m_face_records;
+    u32 m_polygon_records;   // faces with more than three corners
+    u32 m_skipped_faces;     // faces with invalid or out of range indices
+
+    // Vertex count if every triangle corner got its own vertex, i.e. before
+    // deduplication. The index count is the same before and after
+    u32 m_corner_count;
+    u32 m_vertex_count;
+  };
+
+  struct obj_mesh {
+    std::vector <glm::vec3> m_positions;
+    std::vector <glm::vec2> m_texcoords; // empty unless requested and present
+    std::vector <glm::vec3> m_normals;   // empty unless requested and present
+    std::vector <u32> m_indices;
+
+    obj_statistics m_statistics;
+
+    void clear ();
+  };
+
+  // Parses Wavefront OBJ text in [begin, end) into the mesh. `v`, `vt`, `vn`
+  // and `f` records are read, everything else is skipped. Faces with more
+  // than three corners are triangulated as fans and negative (relative)
+  // indices are resolved. Each distinct combination of the requested
+  // attributes becomes one vertex. The buffer is parsed in place, no line is
+  // ever copied.
+  void parse_obj (const char*, const char*, obj_mesh&, u32 = obj_attribute::position);
+
+  // Memory maps the file and parses it like parse_obj. Given a job system,
+  // files larger than a few hundred KB are split at line boundaries into up
+  // to one chunk per thread, which are parsed as jobs; the result is
+  // identical to a single threaded parse. Returns false (and leaves the mesh
+  // empty) if the file could not be read.
+  bool load_obj (const std::string&, obj_mesh&, u32 = obj_attribute::position, job_system* = nullptr);
+
+} // namespace gl
+
+#endif // HEADER_MESH_OBJ_LOADER_H
@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <cmath>
+
+#include "broad_phase.hpp"
+
+namespace gl {
+
+  // Past this many moves per end the insertion sort gives up and sorts from
+  // scratch, the order was not close to sorted (a new scene, say)
+  static constexpr u64 max_moves_per_end = 16;
+
+  // Boxes covering more cells than this are tested against every box
+  static constexpr f64 max_cells_per_box = 64;
+
+  // Boxes per job of spatial_hash::find_pairs
+  static constexpr u32 query_block = 4096;
+
+  static bool overlap (const bounding_box&, const bounding_box&);
+  static collision_pair make_pair (u32, u32);
+  static u64 pair_key (u32, u32);
+  static u64 cell_key (i64, i64, i64);
+  static u32 bucket_of (u64, u32);
+
+  sweep_and_prune::sweep_and_prune ()
+    : m_endpoints (),
+      m_pairs (),
+      m_order () {
+
+  }
+
+  void sweep_and_prune::find_pairs (const std::vector <bounding_box> &boxes, std::vector <collision_pair> &pairs) {
+    bool sorted = m_endpoints[0].size() == 2 * boxes.size();
+
+    for (u32 axis = 0; axis < 3 and sorted; ++axis)
+      sorted = update_axis(axis, boxes);
+
+    if (not sorted)
+      rebuild(boxes);
+
+    for (u64 key: m_pairs)
+      pairs.push_back({static_cast <u32> (key >> 32), static_cast <u32> (key)});
+  }
+
+  // Lower ends go first on a tie, so touching boxes overlap like they do
+  // for overlap
+  bool sweep_and_prune::is_before (const endpoint &a, const endpoint &b) {
+    return a.m_value < b.m_value or (a.m_value == b.m_value and not a.m_upper and b.m_upper);
+  }
+
+  // Brings the ends along one axis up to date with the boxes, and the pairs
+  // with them. Returns false when it gave up, the pairs are then stale
+  bool sweep_and_prune::update_axis (u32 axis, const std::vector <bounding_box> &boxes) {
+    auto &ends = m_endpoints[axis];
+    u32 size = ends.size();
+
+    for (endpoint &end: ends)
+      end.m_value = end.m_upper ? boxes[end.m_box].m_max[axis] : boxes[end.m_box].m_min[axis];
+
+    u64 moves = 0;
+    u64 max_moves = max_moves_per_end * size;
+
+    for (u32 i = 1; i < size; ++i) {
+      endpoint end = ends[i];
+      u32 j = i;
+
+      for (; j > 0 and is_before(end, ends[j - 1]); --j) {
+        const endpoint &passed = ends[j - 1];
+
+        // Passing an end of the same kind, or of the same box, changes no
+        // overlap
+        if (end.m_upper != passed.m_upper and end.m_box != passed.m_box) {
+          u64 key = pair_key(end.m_box, passed.m_box);
+
+          if (end.m_upper)
+            m_pairs.erase(key);
+          else if (overlap(boxes[end.m_box], boxes[passed.m_box]))
+            m_pairs.insert(key);
+        }
+
+        ends[j] = passed;
+      }
+
+      ends[j] = end;
+      moves += i - j;
+
+      if (moves > max_moves)
+        return false;
+    }
+
+    return true;
+  }
+
+  // Sorts the ends from scratch and finds the pairs with one sweep along x,
+  // for new boxes or boxes that moved too far
+  void sweep_and_prune::rebuild (const std::vector <bounding_box> &boxes) {
+    u32 count = boxes.size();
+
+    for (u32 axis = 0; axis < 3; ++axis) {
+      auto &ends = m_endpoints[axis];
+      ends.resize(2 * count);
+
+      for (u32 i = 0; i < count; ++i) {
+        ends[2 * i] = {boxes[i].m_min[axis], i, false};
+        ends[2 * i + 1] = {boxes[i].m_max[axis], i, true};
+      }
+
+      std::sort(ends.begin(), ends.end(), is_before);
+    }
+
+    m_order.clear();
+
+    for (const endpoint &end: m_endpoints[0])
+      if (not end.m_upper and not boxes[end.m_box].is_empty())
+        m_order.push_back(end.m_box);
+
+    // Every box against the boxes after it that start before it ends
+    m_pairs.clear();
+
+    for (u32 i = 0; i < m_order.size(); ++i) {
+      const bounding_box &box = boxes[m_order[i]];
+
+      for (u32 j = i + 1; j < m_order.size(); ++j) {
+        const bounding_box &other = boxes[m_order[j]];
+
+        if (other.m_min.x > box.m_max.x)
+          break;
+
+        if (overlap(box, other))
+          m_pairs.insert(pair_key(m_order[i], m_order[j]));
+      }
+    }
+  }
+
+  spatial_hash::spatial_hash ()
+    : m_extents (),
+      m_oversized (),
+      m_bucket_start (),
+      m_entries (),
+      m_block_pairs () {
+
+  }
+
+  void spatial_hash::find_pairs (const std::vector <bounding_box> &boxes, std::vector <collision_pair> &pairs, job_system &jobs) {
+    u32 count = boxes.size();
+    m_extents.clear();
+
+    for (const auto &box: boxes) {
+      if (box.is_empty())
+        continue;
+
+      glm::vec3 size = box.m_max - box.m_min;
+      m_extents.push_back(std::max({size.x, size.y, size.z}));
+    }
+
+    if (m_extents.empty())
+      return;
+
+    auto median = m_extents.begin() + m_extents.size() / 2;
+    std::nth_element(m_extents.begin(), median, m_extents.end());
+
+    // With mostly points, any size does as long as it is not 0
+    f32 cell_size = *median;
+
+    if (cell_size <= 0.0f)
+      cell_size = *std::max_element(median, m_extents.end());
+
+    if (cell_size <= 0.0f)
+      cell_size = 1.0f;
+
+    auto cell_of = [&] (f32 position) {
+      return static_cast <i64> (std::floor(position / cell_size));
+    };
+
+    auto cells_covered = [&] (const bounding_box &box) {
+      f64 cells = 1.0;
+
+      for (u32 axis = 0; axis < 3; ++axis)
+        cells *= std::floor(box.m_max[axis] / cell_size) - std::floor(box.m_min[axis] / cell_size) + 1.0;
+
+      return cells;
+    };
+
+    auto for_each_cell = [&] (const bounding_box &box, auto &&function) {
+      i64 low[3] = {cell_of(box.m_min.x), cell_of(box.m_min.y), cell_of(box.m_min.z)};
+      i64 high[3] = {cell_of(box.m_max.x), cell_of(box.m_max.y), cell_of(box.m_max.z)};
+
+      for (i64 x = low[0]; x <= high[0]; ++x)
+        for (i64 y = low[1]; y <= high[1]; ++y)
+          for (i64 z = low[2]; z <= high[2]; ++z)
+            function(cell_key(x, y, z));
+    };
+
+    m_oversized.assign(count, 0);
+    u64 entry_count = 0;
+
+    for (u32 i = 0; i < count; ++i) {
+      if (boxes[i].is_empty())
+        continue;
+
+      f64 cells = cells_covered(boxes[i]);
+
+      if (cells > max_cells_per_box)
+        m_oversized[i] = 1;
+      else
+        entry_count += static_cast <u64> (cells);
+    }
+
+    u32 bucket_count = 1;
+
+    while (bucket_count < 2 * entry_count)
+      bucket_count *= 2;
+
+    auto is_filed = [&] (u32 i) { return not boxes[i].is_empty() and not m_oversized[i]; };
+
+    // A counting sort of the entries by bucket: count them, turn the counts
+    // into where each bucket ends, then fill every bucket from its start
+    m_bucket_start.assign(bucket_count + 1, 0);
+
+    for (u32 i = 0; i < count; ++i)
+      if (is_filed(i))
+        for_each_cell(boxes[i], [&] (u64 cell) { ++m_bucket_start[bucket_of(cell, bucket_count) + 1]; });
+
+    for (u32 b = 0; b < bucket_count; ++b)
+      m_bucket_start[b + 1] += m_bucket_start[b];
+
+    m_entries.resize(m_bucket_start[bucket_count]);
+
+    for (u32 i = 0; i < count; ++i)
+      if (is_filed(i))
+        for_each_cell(boxes[i], [&] (u64 cell) { m_entries[m_bucket_start[bucket_of(cell, bucket_count)]++] = {cell, i}; });
+
+    // Filling moved every start to the start of the next bucket
+    for (u32 b = bucket_count; b > 0; --b)
+      m_bucket_start[b] = m_bucket_start[b - 1];
+
+    m_bucket_start[0] = 0;
+
+    u32 block_count = (count + query_block - 1) / query_block;
+    m_block_pairs.resize(block_count);
+
+    jobs.parallel_for(0, block_count, 1, [&] (u32 first, u32 last) {
+      for (u32 block = first; block < last; ++block) {
+        auto &block_pairs = m_block_pairs[block];
+        block_pairs.clear();
+
+        for (u32 i = block * query_block; i < std::min(count, (block + 1) * query_block); ++i) {
+          const bounding_box &box = boxes[i];
+
+          if (box.is_empty())
+            continue;
+
+          // Filed boxes never find an oversized one, oversized ones find
+          // each other from their lower index
+          if (m_oversized[i]) {
+            for (u32 j = 0; j < count; ++j)
+              if (j != i and (not m_oversized[j] or j > i) and overlap(box, boxes[j]))
+                block_pairs.push_back(make_pair(i, j));
+
+            continue;
+          }
+
+          for_each_cell(box, [&] (u64 cell) {
+            u32 bucket = bucket_of(cell, bucket_count);
+
+            // Buckets are shared by unrelated cells, the key tells them
+            // apart. Each pair is found from its lower index, in the cell
+            // of the lower corner of the overlap, which both boxes cover
+            for (u32 e = m_bucket_start[bucket]; e < m_bucket_start[bucket + 1]; ++e) {
+              const cell_entry &entry = m_entries[e];
+              u32 j = entry.m_box;
+
+              if (j <= i or entry.m_cell != cell or not overlap(box, boxes[j]))
+                continue;
+
+              const bounding_box &other = boxes[j];
+              u64 corner = cell_key(
+                cell_of(std::max(box.m_min.x, other.m_min.x)),
+                cell_of(std::max(box.m_min.y, other.m_min.y)),
+                cell_of(std::max(box.m_min.z, other.m_min.z))
+              );
+
+              if (corner == cell)
+                block_pairs.push_back({i, j});
+            }
+          });
+        }
+      }
+    });
+
+    for (const auto &block_pairs: m_block_pairs)
+      pairs.insert(pairs.end(), block_pairs.begin(), block_pairs.end());
+  }
+
+  bool overlap (const bounding_box &a, const bounding_box &b) {
+    return a.m_min.x <= b.m_max.x and b.m_min.x <= a.m_max.x
+      and a.m_min.y <= b.m_max.y and b.m_min.y <= a.m_max.y
+      and a.m_min.z <= b.m_max.z and b.m_min.z <= a.m_max.z;
+  }
+
+  collision_pair make_pair (u32 a, u32 b) {
+    return a < b ? collision_pair {a, b} : collision_pair {b, a};
+  }
+
+  // The pair as m_first << 32 | m_second
+  u64 pair_key (u32 a, u32 b) {
+    collision_pair pair = make_pair(a, b);
+    return static_cast <u64> (pair.m_first) << 32 | pair.m_second;
+  }
+
+  // 21 bits per axis, cells from -2^20 to 2^20 - 1
+  u64 cell_key (i64 x, i64 y, i64 z) {
+    constexpr i64 bias = 1 << 20;
+    constexpr u64 mask = (1 << 21) - 1;
+
+    return (static_cast <u64> (x + bias) & mask)
+      | (static_cast <u64> (y + bias) & mask) << 21
+      | (static_cast <u64> (z + bias) & mask) << 42;
+  }
+
+  // Fibonacci hashing, the high bits of the product are well mixed
+  u32 bucket_of (u64 key, u32 bucket_count) {
+    return static_cast <u32> ((key * 0x9e3779b97f4a7c15ull) >> 32) & (bucket_count - 1);
+  }
+
+} // namespace gl
@@ -0,0 +1,98 @@
+#ifndef HEADER_PHYSICS_BROAD_PHASE_H
+#define HEADER_PHYSICS_BROAD_PHASE_H
+
+#include <unordered_set>
+#include <vector>
+
+#include "types.hpp"
+#include "mesh/bounds.hpp"
+#include "job/job_system.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // Two boxes that overlap, by index, m_first < m_second
+  struct collision_pair {
+    u32 m_first;
+    u32 m_second;
+  };
+
+  // Both broad phases take one box per index, empty boxes take no part, and
+  // append every overlapping pair once, in no particular order
+
+  // Sort and sweep on all three axes, incrementally. Every axis keeps the
+  // lower and upper ends of the boxes sorted from one call to the next,
+  // lower before upper on a tie, and the overlapping pairs are kept too.
+  // Boxes move little between two calls, so an insertion sort brings the
+  // ends up to date in close to linear time, and only the swaps it makes
+  // change the pairs. A lower end passing an upper end on its way down may
+  // start an overlap, checked on all axes. An upper end passing a lower end
+  // ends one. Best when few boxes move far from one call to the next
+  class sweep_and_prune {
+    private:
+      struct endpoint {
+        f32 m_value;
+        u32 m_box;
+        bool m_upper;
+      };
+
+      std::vector <endpoint> m_endpoints[3];
+
+      // Pairs overlapping after the last call, as m_first << 32 | m_second
+      std::unordered_set <u64> m_pairs;
+
+      // Boxes by their lower x, only while rebuilding
+      std::vector <u32> m_order;
+
+    public:
+      sweep_and_prune ();
+
+      void find_pairs (const std::vector <bounding_box>&, std::vector <collision_pair>&);
+
+    private:
+      static bool is_before (const endpoint&, const endpoint&);
+
+      bool update_axis (u32, const std::vector <bounding_box>&);
+      void rebuild (const std::vector <bounding_box>&);
+  };
+
+  // A uniform grid hashed into buckets, so no memory goes to empty cells.
+  // The cells are as large as the median box, so a few large boxes leave the
+  // cells of the others small. Every box is filed under each cell it covers,
+  // and a pair is found in the cell holding the lower corner of where the
+  // two overlap, so only once. Boxes covering more cells than
+  // max_cells_per_box (a floor under everything, say) are tested against
+  // every box instead. Queries run in parallel, in blocks of boxes. Best for
+  // many boxes of similar size packed densely
+  class spatial_hash {
+    private:
+      // A cell packed into one key, and a box covering it
+      struct cell_entry {
+        u64 m_cell;
+        u32 m_box;
+      };
+
+      // The largest extent of every box, for the median
+      std::vector <f32> m_extents;
+
+      // Per box, whether it covers too many cells to be filed under them
+      std::vector <u8> m_oversized;
+
+      // Entries grouped by bucket, bucket b holds
+      // m_entries[m_bucket_start[b]] up to m_entries[m_bucket_start[b + 1]]
+      std::vector <u32> m_bucket_start;
+      std::vector <cell_entry> m_entries;
+
+      // Pairs found by each block of boxes
+      std::vector <std::vector <collision_pair>> m_block_pairs;
+
+    public:
+      spatial_hash ();
+
+      void find_pairs (const std::vector <bounding_box>&, std::vector <collision_pair>&, job_system&);
+  };
+
+} // namespace gl
+
+#endif // HEADER_PHYSICS_BROAD_PHASE_H
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "collision_system.hpp"
+
+namespace gl {
+
+  // Slots per job when placing the colliders
+  static constexpr u32 collider_grain = 4096;
+
+  collision_system::collision_system ()
+    : m_spheres (),
+      m_boxes (),
+      m_pairs (),
+      m_sweep_and_prune (),
+      m_spatial_hash (),
+      m_statistics {0, 0, 0, 0.0f, 0.0f} {
+
+  }
+
+  void collision_system::resolve (transform_storage &state, broad_phase_type type, job_system &jobs) {
+    using clock = std::chrono::steady_clock;
+
+    clock::time_point start = clock::now();
+    u32 size = state.get_size();
+
+    m_spheres.resize(size);
+    m_boxes.resize(size);
+
+    jobs.parallel_for(0, size, collider_grain, [&] (u32 first, u32 last) {
+      for (u32 i = first; i < last; ++i) {
+        if (state.get_collider(i).w <= 0.0f) {
+          m_boxes[i] = bounding_box();
+          continue;
+        }
+
+        glm::vec4 sphere = state.get_world_collider(i);
+        glm::vec3 center (sphere);
+
+        m_spheres[i] = sphere;
+        m_boxes[i] = bounding_box(center - glm::vec3(sphere.w), center + glm::vec3(sphere.w));
+      }
+    });
+
+    m_pairs.clear();
+
+    if (type == broad_phase_type::sweep_and_prune)
+      m_sweep_and_prune.find_pairs(m_boxes, m_pairs);
+    else
+      m_spatial_hash.find_pairs(m_boxes, m_pairs, jobs);
+
+    std::sort(m_pairs.begin(), m_pairs.end(), [] (const collision_pair &a, const collision_pair &b) {
+      return a.m_first != b.m_first ? a.m_first < b.m_first : a.m_second < b.m_second;
+    });
+
+    clock::time_point middle = clock::now();
+    u32 contacts = 0;
+
+    // One pair at a time, a slot may be part of several
+    for (const auto &pair: m_pairs) {
+      glm::vec4 &a = m_spheres[pair.m_first];
+      glm::vec4 &b = m_spheres[pair.m_second];
+
+      glm::vec3 offset = glm::vec3(b) - glm::vec3(a);
+      f32 distance_squared = glm::dot(offset, offset);
+      f32 reach = a.w + b.w;
+
+      // Spheres with the same center have no direction to part in
+      if (distance_squared >= reach * reach or distance_squared == 0.0f)
+        continue;
+
+      f32 distance = std::sqrt(distance_squared);
+      glm::vec3 normal = offset / distance;
+
+      // Each moves back half the overlap
+      glm::vec3 correction = normal * ((reach - distance) * 0.5f);
+
+      state.set_position(pair.m_first, state.get_position(pair.m_first) - correction);
+      state.set_position(pair.m_second, state.get_position(pair.m_second) + correction);
+      a -= glm::vec4(correction, 0.0f);
+      b += glm::vec4(correction, 0.0f);
+
+      // Equal masses bouncing elastically trade their velocities along the
+      // normal. Ones already moving apart are left alone
+      glm::vec3 velocity_a = state.get_velocity(pair.m_first);
+      glm::vec3 velocity_b = state.get_velocity(pair.m_second);
+      f32 approach = glm::dot(velocity_a - velocity_b, normal);
+
+      if (approach > 0.0f) {
+        state.set_velocity(pair.m_first, velocity_a - normal * approach);
+        state.set_velocity(pair.m_second, velocity_b + normal * approach);
+      }
+
+      ++contacts;
+    }
+
+    clock::time_point stop = clock::now();
+
+    m_statistics.m_colliders = std::count_if(m_boxes.begin(), m_boxes.end(), [] (const bounding_box &box) { return not box.is_empty(); });
+    m_statistics.m_pairs = m_pairs.size();
+    m_statistics.m_contacts = contacts;
+    m_statistics.m_broad_phase_time = std::chrono::duration <f32, std::milli> (middle - start).count();
+    m_statistics.m_response_time = std::chrono::duration <f32, std::milli> (stop - middle).count();
+  }
+
+  const collision_statistics& collision_system::get_statistics () const {
+    return m_statistics;
+  }
+
+} // namespace gl
@@ -0,0 +1,61 @@
+#ifndef HEADER_PHYSICS_COLLISION_SYSTEM_H
+#define HEADER_PHYSICS_COLLISION_SYSTEM_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "types.hpp"
+#include "transform_storage.hpp"
+#include "mesh/bounds.hpp"
+#include "job/job_system.hpp"
+#include "physics/broad_phase.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  enum class broad_phase_type : u32 {
+    sweep_and_prune,
+    spatial_hash
+  };
+
+  // What the last resolve did, times in milliseconds
+  struct collision_statistics {
+    u32 m_colliders;
+    u32 m_pairs;
+    u32 m_contacts;
+    f32 m_broad_phase_time;
+    f32 m_response_time;
+  };
+
+  // Keeps the slots of a transform storage that have a collider from passing
+  // through each other. The broad phase finds the pairs whose boxes around
+  // the world space colliders overlap; each pair whose spheres really touch
+  // is then pushed apart and, if the two still approach each other, bounced
+  // off as two spheres of equal mass.
+  //
+  // The pairs are resolved in index order, whichever broad phase found them,
+  // so the outcome only depends on the state it is given
+  class collision_system {
+    private:
+      std::vector <glm::vec4> m_spheres;
+      std::vector <bounding_box> m_boxes;
+      std::vector <collision_pair> m_pairs;
+
+      sweep_and_prune m_sweep_and_prune;
+      spatial_hash m_spatial_hash;
+
+      collision_statistics m_statistics;
+
+    public:
+      collision_system ();
+
+      void resolve (transform_storage&, broad_phase_type, job_system&);
+
+      const collision_statistics& get_statistics () const;
+  };
+
+} // namespace gl
+
+#endif // HEADER_PHYSICS_COLLISION_SYSTEM_H
@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "profiler.hpp"
+
+namespace gl {
+
+  static std::string escape_json (const std::string&);
+
+  f64 profiler::scope_statistics::get_average () const {
+    u32 count = std::min(m_samples, history_frames);
+    f64 sum = 0.0;
+
+    for (u32 i = 0; i < count; ++i)
+      sum += m_history[i];
+
+    return count > 0 ? sum / count : 0.0;
+  }
+
+  f64 profiler::scope_statistics::get_max () const {
+    u32 count = std::min(m_samples, history_frames);
+    return count > 0 ? *std::max_element(m_history.begin(), m_history.begin() + count) : 0.0;
+  }
+
+  profiler::profiler ()
+    : m_origin (clock::now()),
+      m_frame (0),
+      m_cpu_stack (),
+      m_gpu_stack (),
+      m_pending (),
+      m_free_queries (),
+      m_queries (),
+      m_gpu_offset (0.0),
+      m_scopes (),
+      m_scope_indices (),
+      m_capture (),
+      m_capture_begin (0),
+      m_capture_end (0),
+      m_capture_path () {
+
+  }
+
+  profiler::~profiler () {
+    if (not m_queries.empty())
+      glDeleteQueries(m_queries.size(), m_queries.data());
+  }
+
+  void profiler::begin_frame () {
+    ++m_frame;
+
+    i64 gpu_time = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu_time);
+    m_gpu_offset = now() - gpu_time / 1e3;
+
+    m_cpu_stack.clear();
+    m_gpu_stack.clear();
+
+    resolve_gpu_scopes();
+
+    if (not is_capturing() or m_frame < m_capture_end)
+      return;
+
+    bool waiting = std::any_of(m_pending.begin(), m_pending.end(), [&] (const pending_gpu_scope &scope) {
+      return scope.m_frame < m_capture_end;
+    });
+
+    if (waiting)
+      return;
+
+    write_capture();
+    m_capture.clear();
+    m_capture_path.clear();
+  }
+
+  void profiler::begin_cpu (const std::string &name) {
+    m_cpu_stack.push_back({name, now(), 0});
+  }
+
+  void profiler::end_cpu () {
+    if (m_cpu_stack.empty())
+      return;
+
+    open_scope scope = std::move(m_cpu_stack.back());
+    m_cpu_stack.pop_back();
+
+    record({scope.m_name, false, static_cast <u32> (m_cpu_stack.size()), m_frame, scope.m_begin, now() - scope.m_begin});
+  }
+
+  void profiler::begin_gpu (const std::string &name) {
+    u32 query = acquire_query();
+    glQueryCounter(query, GL_TIMESTAMP);
+
+    m_gpu_stack.push_back({name, 0.0, query});
+  }
+
+  void profiler::end_gpu () {
+    if (m_gpu_stack.empty())
+      return;
+
+    open_scope scope = std::move(m_gpu_stack.back());
+    m_gpu_stack.pop_back();
+
+    u32 query = acquire_query();
+    glQueryCounter(query, GL_TIMESTAMP);
+
+    m_pending.push_back({scope.m_name, static_cast <u32> (m_gpu_stack.size()), m_frame, scope.m_begin_query, query});
+  }
+
+  void profiler::capture (u32 frames, const std::string &path) {
+    if (is_capturing())
+      return;
+
+    m_capture.clear();
+    m_capture_begin = m_frame + 1;
+    m_capture_end = m_capture_begin + frames;
+    m_capture_path = path;
+  }
+
+  bool profiler::is_capturing () const {
+    return not m_capture_path.empty();
+  }
+
+  const std::vector <profiler::scope_statistics>& profiler::get_scopes () const {
+    return m_scopes;
+  }
+
+  f64 profiler::now () const {
+    return std::chrono::duration <f64, std::micro> (clock::now() - m_origin).count();
+  }
+
+  // Queries are made as they are needed, the profiler exists before the GL
+  // context does
+  u32 profiler::acquire_query () {
+    if (m_free_queries.empty()) {
+      u32 query = 0;
+      glGenQueries(1, &query);
+      m_queries.push_back(query);
+      return query;
+    }
+
+    u32 query = m_free_queries.back();
+    m_free_queries.pop_back();
+    return query;
+  }
+
+  void profiler::resolve_gpu_scopes () {
+    u64 write = 0;
+
+    for (auto &scope: m_pending) {
+      i32 available = 0;
+
+      if (scope.m_frame + frames_in_flight <= m_frame)
+        glGetQueryObjectiv(scope.m_end_query, GL_QUERY_RESULT_AVAILABLE, &available);
+
+      // Too recent, or the GPU is further behind than usual
+      if (not available) {
+        if (&m_pending[write] != &scope)
+          m_pending[write] = std::move(scope);
+
+        ++write;
+        continue;
+      }
+
+      u64 begin = 0;
+      u64 end = 0;
+      glGetQueryObjectui64v(scope.m_begin_query, GL_QUERY_RESULT, &begin);
+      glGetQueryObjectui64v(scope.m_end_query, GL_QUERY_RESULT, &end);
+
+      m_free_queries.push_back(scope.m_begin_query);
+      m_free_queries.push_back(scope.m_end_query);
+
+      record({scope.m_name, true, scope.m_depth, scope.m_frame, begin / 1e3 + m_gpu_offset, (end - begin) / 1e3});
+    }
+
+    m_pending.resize(write);
+  }
+
+  void profiler::record (const event &e) {
+    std::string key = (e.m_gpu ? "gpu:" : "cpu:") + e.m_name;
+    auto index = m_scope_indices.find(key);
+
+    if (index == m_scope_indices.end()) {
+      index = m_scope_indices.emplace(key, m_scopes.size()).first;
+      m_scopes.push_back({e.m_name, e.m_gpu, e.m_depth, {}, 0, 0});
+    }
+
+    // Scopes entered more than once a frame add up to one sample
+    scope_statistics &scope = m_scopes[index->second];
+    f64 milliseconds = e.m_duration / 1e3;
+
+    if (scope.m_samples > 0 and scope.m_last_frame == e.m_frame) {
+      scope.m_history[(scope.m_samples - 1) % history_frames] += milliseconds;
+    }
+    else {
+      scope.m_history[scope.m_samples % history_frames] = milliseconds;
+      ++scope.m_samples;
+      scope.m_last_frame = e.m_frame;
+    }
+
+    scope.m_depth = e.m_depth;
+
+    if (is_capturing() and e.m_frame >= m_capture_begin and e.m_frame < m_capture_end)
+      m_capture.push_back(e);
+  }
+
+  // Complete ("X") events, CPU scopes on thread 1 and GPU scopes on thread 2
+  // of one process
+  void profiler::write_capture () const {
+    std::ofstream file (m_capture_path);
+
+    if (not file) {
+      std::cerr << "Failed to write trace " << m_capture_path << std::endl;
+      return;
+    }
+
+    // Microseconds, to the nanosecond
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+    for (const auto &e: m_capture) {
+      file << ",\n{\"name\":\"" << escape_json(e.m_name) << "\",\"cat\":\"" << (e.m_gpu ? "gpu" : "cpu")
+           << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (e.m_gpu ? 2 : 1)
+           << ",\"ts\":" << e.m_begin << ",\"dur\":" << e.m_duration
+           << ",\"args\":{\"frame\":" << e.m_frame << "}}";
+    }
+
+    file << "\n]}\n";
+
+    std::cout << "Wrote " << m_capture.size() << " events of " << m_capture_end - m_capture_begin
+              << " frames to " << m_capture_path << std::endl;
+  }
+
+  std::string escape_json (const std::string &text) {
+    std::string result;
+
+    for (char c: text) {
+      if (c == '"' or c == '\\')
+        result += '\\';
+
+      result += c;
+    }
+
+    return result;
+  }
+
+  cpu_scope::cpu_scope (profiler &p, const std::string &name)
+    : m_profiler (p) {
+    m_profiler.begin_cpu(name);
+  }
+
+  cpu_scope::~cpu_scope () {
+    m_profiler.end_cpu();
+  }
+
+} // namespace gl
@@ -0,0 +1,147 @@
+#ifndef HEADER_PROFILER_H
+#define HEADER_PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "types.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // Times the scope it is declared in on the CPU, e.g.
+  //
+  //   PROFILE_SCOPE(m_profiler, "Scene update");
+  #define PROFILE_CONCAT_INNER(a, b) a##b
+  #define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+  #define PROFILE_SCOPE(profiler, name) gl::cpu_scope PROFILE_CONCAT(profile_scope_, __LINE__) (profiler, name)
+
+  // Nested CPU and GPU scopes of every frame.
+  //
+  // CPU scopes are timed with a steady clock. GPU scopes are pairs of
+  // GL_TIMESTAMP queries from a pool, read frames_in_flight frames later when
+  // the GPU is done with them, so reading never stalls. GPU times are moved
+  // into the CPU clock's time line with an offset measured every frame.
+  //
+  // Every scope keeps its time over the last history_frames frames for the
+  // Debug window, and capture records frames for a Chrome trace_event file
+  // (chrome://tracing, Perfetto)
+  class profiler {
+    public:
+      static constexpr u32 history_frames = 120;
+
+      struct scope_statistics {
+        std::string m_name;
+        bool m_gpu;
+        u32 m_depth;
+        std::array <f64, history_frames> m_history;
+        u32 m_samples;
+        u64 m_last_frame;
+
+        f64 get_average () const;
+        f64 get_max () const;
+      };
+
+    private:
+      static constexpr u32 frames_in_flight = 3;
+
+      using clock = std::chrono::steady_clock;
+
+      // Times are in microseconds since m_origin, the unit of trace_event
+      struct event {
+        std::string m_name;
+        bool m_gpu;
+        u32 m_depth;
+        u64 m_frame;
+        f64 m_begin;
+        f64 m_duration;
+      };
+
+      struct open_scope {
+        std::string m_name;
+        f64 m_begin;
+        u32 m_begin_query;
+      };
+
+      struct pending_gpu_scope {
+        std::string m_name;
+        u32 m_depth;
+        u64 m_frame;
+        u32 m_begin_query;
+        u32 m_end_query;
+      };
+
+      clock::time_point m_origin;
+      u64 m_frame;
+
+      std::vector <open_scope> m_cpu_stack;
+      std::vector <open_scope> m_gpu_stack;
+      std::vector <pending_gpu_scope> m_pending;
+      std::vector <u32> m_free_queries;
+      std::vector <u32> m_queries;
+
+      // CPU microseconds minus GPU microseconds, measured once per frame
+      f64 m_gpu_offset;
+
+      std::vector <scope_statistics> m_scopes;
+      std::unordered_map <std::string, u32> m_scope_indices;
+
+      // Frames [m_capture_begin, m_capture_end) are recorded while capturing
+      std::vector <event> m_capture;
+      u64 m_capture_begin;
+      u64 m_capture_end;
+      std::string m_capture_path;
+
+    public:
+      profiler ();
+      ~profiler ();
+
+      profiler (const profiler&) = delete;
+      profiler& operator = (const profiler&) = delete;
+
+      // Starts a frame, reads back the GPU scopes old enough and writes a
+      // finished capture. Call before the first scope of the frame
+      void begin_frame ();
+
+      void begin_cpu (const std::string&);
+      void end_cpu ();
+
+      // GPU scopes may nest, but only within the frame they began in
+      void begin_gpu (const std::string&);
+      void end_gpu ();
+
+      // Records the next `frames` frames and writes them to `path` once the
+      // last of their GPU scopes is read back
+      void capture (u32, const std::string&);
+      bool is_capturing () const;
+
+      // In order of first appearance
+      const std::vector <scope_statistics>& get_scopes () const;
+
+    private:
+      f64 now () const;
+      u32 acquire_query ();
+      void resolve_gpu_scopes ();
+      void record (const event&);
+      void write_capture () const;
+  };
+
+  class cpu_scope {
+    private:
+      profiler &m_profiler;
+
+    public:
+      cpu_scope (profiler&, const std::string&);
+      ~cpu_scope ();
+
+      cpu_scope (const cpu_scope&) = delete;
+      cpu_scope& operator = (const cpu_scope&) = delete;
+  };
+
+} // namespace gl
+
+#endif // HEADER_PROFILER_H
@@ -0,0 +1,53 @@
+#include <glad/glad.h>
+
+#include "render_graph.hpp"
+#include "renderer.hpp"
+
+namespace gl {
+
+  render_graph::render_graph ()
+    : m_nodes (),
+      m_dirty (true) {
+
+  }
+
+  u32 render_graph::add_pass (const graph_pass &pass) {
+    node n {pass, true, culled};
+    n.m_pass.m_state.m_stencil_write_mask = pass.m_writes & stencil_resource ? 0xff : 0x00;
+
+    m_nodes.push_back(n);
+    m_dirty = true;
+
+    return m_nodes.size() - 1;
+  }
+
+  void render_graph::set_enabled (u32 pass, bool enabled) {
+    if (m_nodes[pass].m_enabled == enabled)
+      return;
+
+    m_nodes[pass].m_enabled = enabled;
+    m_dirty = true;
+  }
+
+  bool render_graph::compile (render_queue &queue) {
+    if (not m_dirty)
+      return false;
+
+    queue.clear_passes();
+
+    for (node &n: m_nodes)
+      n.m_queue_pass = n.m_enabled ? queue.add_pass(n.m_pass.m_state, n.m_pass.m_name) : culled;
+
+    m_dirty = false;
+    return true;
+  }
+
+  bool render_graph::is_active (u32 pass) const {
+    return m_nodes[pass].m_queue_pass != culled;
+  }
+
+  u32 render_graph::get_queue_pass (u32 pass) const {
+    return m_nodes[pass].m_queue_pass;
+  }
+
+} // namespace gl
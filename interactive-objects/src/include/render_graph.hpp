@@ -0,0 +1,71 @@
+#ifndef HEADER_RENDER_GRAPH_H
+#define HEADER_RENDER_GRAPH_H
+
+#include <string>
+#include <vector>
+
+#include "types.hpp"
+#include "render_queue.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // What passes write, combined into masks
+  enum render_resource : u32 {
+    color_resource = 1 << 0,
+    depth_resource = 1 << 1,
+    stencil_resource = 1 << 2
+  };
+
+  // A pass as declared to the graph. The stencil write mask of the state
+  // follows from whether the pass writes stencil_resource
+  struct graph_pass {
+    std::string m_name;
+    render_pass m_state;
+    u32 m_writes;
+  };
+
+  // The passes of a frame in the order they run, and the render_queue
+  // passes they turn into.
+  //
+  // Every pass draws straight into the default framebuffer, there are no
+  // intermediate targets whose readers could all be disabled, so compile
+  // only culls the disabled passes. Neighbouring passes never share their
+  // state either, each active pass is its own queue pass. Draws are
+  // submitted to a graph pass only while it is active, so a disabled visual
+  // mode costs nothing
+  class render_graph {
+    private:
+      struct node {
+        graph_pass m_pass;
+        bool m_enabled;
+        u32 m_queue_pass;
+      };
+
+      std::vector <node> m_nodes;
+      bool m_dirty;
+
+    public:
+      static constexpr u32 culled = ~0u;
+
+      render_graph ();
+
+      // Returns the pass id draws are submitted with, passes run in the order
+      // they were added
+      u32 add_pass (const graph_pass&);
+      void set_enabled (u32, bool);
+
+      // Replaces the passes of the queue when the graph changed since the
+      // last compile. Returns whether it did
+      bool compile (render_queue&);
+
+      bool is_active (u32) const;
+
+      // The queue pass draws of a graph pass go to, culled if it is not active
+      u32 get_queue_pass (u32) const;
+  };
+
+} // namespace gl
+
+#endif // HEADER_RENDER_GRAPH_H
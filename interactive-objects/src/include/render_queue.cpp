@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <array>
+#include <iostream>
+
+#include <glad/glad.h>
+
+#include "render_queue.hpp"
+
+namespace gl {
+
+  static constexpr u32 depth_bits = 24;
+  static constexpr u64 depth_max = (1ull << depth_bits) - 1;
+
+  static u64 quantize_depth (f32);
+
+  render_queue::render_queue ()
+    : m_passes (),
+      m_pass_names (),
+      m_packets (),
+      m_entries (),
+      m_scratch (),
+      m_order () {
+
+  }
+
+  u32 render_queue::add_pass (const render_pass &pass, const std::string &name) {
+    if (m_passes.size() == max_passes) {
+      std::cerr << "render queue is limited to " << max_passes << " passes" << std::endl;
+      return max_passes - 1;
+    }
+
+    m_passes.push_back(pass);
+    m_pass_names.push_back(name);
+    return m_passes.size() - 1;
+  }
+
+  void render_queue::clear_passes () {
+    clear();
+    m_passes.clear();
+    m_pass_names.clear();
+  }
+
+  void render_queue::submit (const draw_packet &packet, f32 depth) {
+    u64 program = packet.m_program->m_program->get_id() & 0xff;
+    u64 vertex_array = packet.m_vertex_array->get_id() & 0xffff;
+    u64 distance = quantize_depth(depth);
+    u64 key = static_cast <u64> (packet.m_pass) << 60;
+
+    if (m_passes[packet.m_pass].m_back_to_front)
+      key |= ((depth_max - distance) << 36) | (program << 28) | (vertex_array << 12);
+    else
+      key |= (program << 52) | (vertex_array << 36) | (distance << 12);
+
+    m_entries.push_back({key, static_cast <u32> (m_packets.size())});
+    m_packets.push_back(packet);
+  }
+
+  // Least significant digit first radix sort, a byte at a time. Bytes every
+  // key has in common, like the unused low bits, are skipped
+  void render_queue::sort () {
+    m_scratch.resize(m_entries.size());
+
+    for (u32 shift = 0; shift < 64; shift += 8) {
+      std::array <u32, 256> counts {};
+
+      for (const auto &entry: m_entries)
+        ++counts[(entry.m_key >> shift) & 0xff];
+
+      if (std::find(counts.begin(), counts.end(), m_entries.size()) != counts.end())
+        continue;
+
+      for (u32 i = 0, offset = 0; i < 256; ++i) {
+        u32 count = counts[i];
+        counts[i] = offset;
+        offset += count;
+      }
+
+      for (const auto &entry: m_entries)
+        m_scratch[counts[(entry.m_key >> shift) & 0xff]++] = entry;
+
+      m_entries.swap(m_scratch);
+    }
+
+    m_order.resize(m_entries.size());
+
+    for (u64 i = 0; i < m_entries.size(); ++i)
+      m_order[i] = m_entries[i].m_packet;
+  }
+
+  void render_queue::clear () {
+    m_packets.clear();
+    m_entries.clear();
+    m_order.clear();
+  }
+
+  const render_pass& render_queue::get_pass (u32 pass) const {
+    return m_passes[pass];
+  }
+
+  const std::string& render_queue::get_pass_name (u32 pass) const {
+    return m_pass_names[pass];
+  }
+
+  const std::vector <draw_packet>& render_queue::get_packets () const {
+    return m_packets;
+  }
+
+  const std::vector <u32>& render_queue::get_order () const {
+    return m_order;
+  }
+
+  // Depths outside of [0, 1] (and NaN) are clamped into it
+  u64 quantize_depth (f32 depth) {
+    if (not (depth > 0.0f))
+      return 0;
+
+    return static_cast <u64> (std::min(depth, 1.0f) * depth_max);
+  }
+
+} // namespace gl
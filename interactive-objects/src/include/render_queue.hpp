@@ -0,0 +1,135 @@
+#ifndef HEADER_RENDER_QUEUE_H
+#define HEADER_RENDER_QUEUE_H
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "types.hpp"
+#include "vertex/vertex_array.hpp"
+#include "vertex/index_buffer.hpp"
+#include "shader/shader.hpp"
+#include "shader/palette_buffer.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  enum class draw_mode;
+
+  // A program reading its per draw data from the texture buffer bound to
+  // unit 0, a record of draw_data_texels RGBA32F texels per draw:
+  //
+  //   0..3  model matrix columns
+  //   4     color
+  //   5     blend, whether to use the vertex colors (0 or 1), palette
+  //         offset and size, see palette_buffer
+  //   6     stencil value, for ARB_shader_stencil_export
+  //
+  // `m_draw` is the index of the record of the draw. In a multi draw it is
+  // the record of the first draw, the shader adds gl_DrawIDARB
+  struct draw_program {
+    const shader_program *m_program;
+    uniform <i32> m_draw;
+  };
+
+  static constexpr u32 draw_data_texels = 7;
+
+  // Fixed function state shared by every draw of a pass, applied when the
+  // renderer reaches the first packet of the pass
+  struct render_pass {
+    draw_mode m_draw_mode;
+    u32 m_polygon_mode;
+    f32 m_line_width;
+    u32 m_stencil_write_mask;
+
+    // Blended passes are drawn back to front, others front to back
+    bool m_back_to_front;
+  };
+
+  // Everything one draw call needs. Packets with an instance count draw that
+  // many instances, their per instance data comes from the vertex array
+  // (see instance_batch) and the per draw data is ignored
+  struct draw_packet {
+    u32 m_pass;
+    const draw_program *m_program;
+    const vertex_array *m_vertex_array;
+    const index_buffer *m_index_buffer;
+    u32 m_index_offset;
+    u32 m_index_count;
+    i32 m_base_vertex;
+
+    glm::mat4 m_model;
+    f32 m_blend;
+    glm::vec4 m_color;
+    bool m_use_vertex_color;
+    color_palette m_palette;
+    i32 m_stencil_ref;
+    u32 m_instance_count;
+  };
+
+  // Draws submitted in any order and executed by renderer::draw_queue in the
+  // order of a 64 bit key
+  //
+  //   63..60  pass, in the order the passes were added
+  //
+  //   front to back passes
+  //   59..52  program
+  //   51..36  vertex array
+  //   35..12  depth, nearest first
+  //
+  //   back to front passes
+  //   59..36  depth, farthest first
+  //   35..28  program
+  //   27..12  vertex array
+  //
+  // so opaque passes change as little state as possible and let early depth
+  // testing reject hidden fragments, and blended ones composite correctly.
+  // Equal keys keep their submission order
+  class render_queue {
+    private:
+      struct sort_entry {
+        u64 m_key;
+        u32 m_packet;
+      };
+
+      std::vector <render_pass> m_passes;
+      std::vector <std::string> m_pass_names;
+      std::vector <draw_packet> m_packets;
+      std::vector <sort_entry> m_entries;
+      std::vector <sort_entry> m_scratch;
+      std::vector <u32> m_order;
+
+    public:
+      static constexpr u32 max_passes = 16;
+
+      render_queue ();
+
+      // Returns the pass id packets are submitted with. The name is what the
+      // profiler shows the pass as
+      u32 add_pass (const render_pass&, const std::string& = "");
+
+      // The depth is the view space distance in [0, 1] of the far plane
+      void submit (const draw_packet&, f32);
+
+      // Orders the packets submitted since the last clear
+      void sort ();
+
+      // Drops the packets, the passes stay
+      void clear ();
+
+      // Drops the packets and the passes, for a new set of passes
+      void clear_passes ();
+
+      const render_pass& get_pass (u32) const;
+      const std::string& get_pass_name (u32) const;
+      const std::vector <draw_packet>& get_packets () const;
+
+      // Indices into get_packets () in draw order, valid after sort
+      const std::vector <u32>& get_order () const;
+  };
+
+} // namespace gl
+
+#endif // HEADER_RENDER_QUEUE_H
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cstring>
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -5,26 +8,282 @@
 
 namespace gl {
 
+  static bool has_extension (const char*);
+
   renderer::renderer ()
     : m_clear_color (0.0f, 0.0f, 0.0f, 1.0f),
-      m_draw_mode (draw_mode::triangle) {
-
+      m_draw_mode (draw_mode::triangle),
+      m_state (),
+      m_statistics (),
+      m_draw_data (),
+      m_draw_buffer (nullptr),
+      m_draw_commands (),
+      m_indirect_buffer (nullptr),
+      m_max_draws (0),
+      m_multi_draw (false),
+      m_stencil_export (false) {
+    begin_frame();
   }
 
   renderer::~renderer () {
 
   }
 
+  void renderer::begin_frame () {
+    m_state.m_program = unknown_state;
+    m_state.m_vertex_array = unknown_state;
+    m_state.m_index_buffer = unknown_state;
+    m_state.m_polygon_mode = unknown_state;
+    m_state.m_stencil_write_mask = unknown_state;
+    m_state.m_stencil_func = unknown_state;
+    m_state.m_stencil_ref = unknown_state;
+    m_state.m_stencil_mask = unknown_state;
+    m_state.m_line_width = -1.0f;
+    m_state.m_capabilities.clear();
+
+    m_statistics = {};
+  }
+
   void renderer::clear () const {
     glClear(GL_COLOR_BUFFER_BIT);
   }
 
-  void renderer::draw_elements (const vertex_array &va, const index_buffer &ib, const shader_program &s) const {
-    s.bind();
-    va.bind();
-    ib.bind();
+  void renderer::draw_elements (const vertex_array &va, const index_buffer &ib, const shader_program &s) {
+    use_program(s);
+    bind_vertex_array(va);
+    bind_index_buffer(ib);
+
+    glDrawElements(static_cast <u32> (m_draw_mode), ib.get_count(), ib.get_type(), static_cast <const void*> (0));
+    ++m_statistics.m_draw_calls;
+  }
+
+  // Draws `count` indices starting at index `offset`, e.g. one level of detail,
+  // each added to `base_vertex`, e.g. the start of a mesh in a mesh_buffer
+  void renderer::draw_elements (const vertex_array &va, const index_buffer &ib, const shader_program &s, u32 offset, u32 count, i32 base_vertex) {
+    use_program(s);
+    bind_vertex_array(va);
+    bind_index_buffer(ib);
+
+    u64 index_size = ib.get_type_size();
+
+    glDrawElementsBaseVertex(
+      static_cast <u32> (m_draw_mode), count, ib.get_type(),
+      reinterpret_cast <const void*> (static_cast <std::uintptr_t> (offset * index_size)),
+      base_vertex
+    );
+
+    ++m_statistics.m_draw_calls;
+  }
+
+  // Draws `count` indices starting at index `offset` `instances` times, the
+  // attributes with a divisor advance once per instance
+  void renderer::draw_elements_instanced (const vertex_array &va, const index_buffer &ib, const shader_program &s, u32 offset, u32 count, i32 base_vertex, u32 instances) {
+    use_program(s);
+    bind_vertex_array(va);
+    bind_index_buffer(ib);
+
+    u64 index_size = ib.get_type_size();
+
+    glDrawElementsInstancedBaseVertex(
+      static_cast <u32> (m_draw_mode), count, ib.get_type(),
+      reinterpret_cast <const void*> (static_cast <std::uintptr_t> (offset * index_size)),
+      instances, base_vertex
+    );
+
+    ++m_statistics.m_draw_calls;
+  }
+
+  // Draws `count` commands of the indirect buffer starting at command
+  // `first`, the indirect buffer has to be bound
+  void renderer::draw_elements_indirect (const vertex_array &va, const index_buffer &ib, const shader_program &s, u32 first, u32 count) {
+    use_program(s);
+    bind_vertex_array(va);
+    bind_index_buffer(ib);
+
+    glMultiDrawElementsIndirect(
+      static_cast <u32> (m_draw_mode), ib.get_type(),
+      reinterpret_cast <const void*> (static_cast <std::uintptr_t> (first * sizeof(draw_command))),
+      count, 0
+    );
+
+    ++m_statistics.m_draw_calls;
+  }
+
+  void renderer::draw_queue (const render_queue &queue, profiler *profiler) {
+    const auto &packets = queue.get_packets();
+    const auto &order = queue.get_order();
+
+    if (not m_draw_buffer)
+      create_draw_buffers();
+
+    u32 pass = render_queue::max_passes;
+    const draw_program *program = nullptr;
+
+    // The per draw data of a part goes up in one upload, in draw order, and
+    // is numbered from the first draw of the part
+    for (u32 first = 0; first < order.size(); first += m_max_draws) {
+      u32 last = std::min <u32> (order.size(), first + m_max_draws);
+
+      m_draw_data.resize((last - first) * draw_data_texels);
+      m_draw_commands.resize(m_multi_draw ? last - first : 0);
+
+      for (u32 i = first; i < last; ++i) {
+        const draw_packet &packet = packets[order[i]];
+        glm::vec4 *record = &m_draw_data[(i - first) * draw_data_texels];
+
+        for (u32 column = 0; column < 4; ++column)
+          record[column] = packet.m_model[column];
+
+        record[4] = packet.m_color;
+        record[5] = glm::vec4(
+          packet.m_blend, packet.m_use_vertex_color ? 1.0f : 0.0f,
+          packet.m_palette.m_offset, packet.m_palette.m_size
+        );
+        record[6] = glm::vec4(packet.m_stencil_ref, 0.0f, 0.0f, 0.0f);
+
+        if (m_multi_draw)
+          m_draw_commands[i - first] = {packet.m_index_count, 1, packet.m_index_offset, packet.m_base_vertex, 0};
+      }
+
+      m_draw_buffer->update(m_draw_data.data(), m_draw_data.size() * sizeof(glm::vec4));
+      m_draw_buffer->bind(0);
+
+      // Left bound for draw_elements_indirect
+      if (m_multi_draw)
+        m_indirect_buffer->update(m_draw_commands.data(), m_draw_commands.size());
+
+      for (u32 i = first; i < last;) {
+        const draw_packet &packet = packets[order[i]];
+
+        if (packet.m_pass != pass) {
+          if (profiler != nullptr) {
+            if (pass != render_queue::max_passes)
+              profiler->end_gpu();
+
+            profiler->begin_gpu(queue.get_pass_name(packet.m_pass));
+          }
+
+          pass = packet.m_pass;
+
+          const render_pass &state = queue.get_pass(pass);
+          set_draw_mode(state.m_draw_mode);
+          set_polygon_mode(state.m_polygon_mode);
+          set_line_width(state.m_line_width);
+          set_stencil_write_mask(state.m_stencil_write_mask);
+        }
+
+        if (packet.m_program != program) {
+          program = packet.m_program;
+          use_program(*program->m_program);
+        }
+
+        set_stencil_func(GL_ALWAYS, packet.m_stencil_ref, 0xff);
+
+        if (packet.m_instance_count > 0) {
+          draw_elements_instanced(
+            *packet.m_vertex_array, *packet.m_index_buffer, *program->m_program,
+            packet.m_index_offset, packet.m_index_count, packet.m_base_vertex,
+            packet.m_instance_count
+          );
+          ++i;
+          continue;
+        }
+
+        program->m_program->set_uniform(program->m_draw, static_cast <i32> (i - first));
+
+        // Following packets that can share its draw go in one multi draw,
+        // u_draw plus gl_DrawIDARB picks their records
+        u32 end = i + 1;
+
+        if (m_multi_draw)
+          while (end < last and can_share_draw(packet, packets[order[end]]))
+            ++end;
+
+        if (end - i > 1)
+          draw_elements_indirect(*packet.m_vertex_array, *packet.m_index_buffer, *program->m_program, i - first, end - i);
+        else
+          draw_elements(
+            *packet.m_vertex_array, *packet.m_index_buffer, *program->m_program,
+            packet.m_index_offset, packet.m_index_count, packet.m_base_vertex
+          );
+
+        i = end;
+      }
+    }
+
+    if (profiler != nullptr and pass != render_queue::max_passes)
+      profiler->end_gpu();
+  }
+
+  void renderer::use_program (const shader_program &s) {
+    if (count_state_change(m_state.m_program != s.get_id())) {
+      s.bind();
+      m_state.m_program = s.get_id();
+    }
+  }
+
+  void renderer::bind_vertex_array (const vertex_array &va) {
+    if (count_state_change(m_state.m_vertex_array != va.get_id())) {
+      va.bind();
+      m_state.m_vertex_array = va.get_id();
+
+      // The element array binding is part of the vertex array state
+      m_state.m_index_buffer = unknown_state;
+    }
+  }
+
+  void renderer::bind_index_buffer (const index_buffer &ib) {
+    if (count_state_change(m_state.m_index_buffer != ib.get_id())) {
+      ib.bind();
+      m_state.m_index_buffer = ib.get_id();
+    }
+  }
+
+  // glEnable / glDisable
+  void renderer::set_capability (u32 capability, bool enabled) {
+    auto state = m_state.m_capabilities.find(capability);
+
+    if (count_state_change(state == m_state.m_capabilities.end() or state->second != enabled)) {
+      (enabled ? glEnable : glDisable)(capability);
+      m_state.m_capabilities[capability] = enabled;
+    }
+  }
+
+  // Always for both faces, the only polygon mode core profiles allow
+  void renderer::set_polygon_mode (u32 mode) {
+    if (count_state_change(m_state.m_polygon_mode != mode)) {
+      glPolygonMode(GL_FRONT_AND_BACK, mode);
+      m_state.m_polygon_mode = mode;
+    }
+  }
+
+  void renderer::set_stencil_write_mask (u32 mask) {
+    if (count_state_change(m_state.m_stencil_write_mask != mask)) {
+      glStencilMask(mask);
+      m_state.m_stencil_write_mask = mask;
+    }
+  }
+
+  void renderer::set_stencil_func (u32 func, i32 ref, u32 mask) {
+    bool changed = m_state.m_stencil_func != func or m_state.m_stencil_ref != static_cast <u32> (ref) or m_state.m_stencil_mask != mask;
+
+    if (count_state_change(changed)) {
+      glStencilFunc(func, ref, mask);
+      m_state.m_stencil_func = func;
+      m_state.m_stencil_ref = ref;
+      m_state.m_stencil_mask = mask;
+    }
+  }
+
+  void renderer::set_line_width (f32 width) {
+    if (count_state_change(m_state.m_line_width != width)) {
+      glLineWidth(width);
+      m_state.m_line_width = width;
+    }
+  }
 
-    glDrawElements(static_cast <u32> (m_draw_mode), ib.get_count(), GL_UNSIGNED_INT, static_cast <const void*> (0));
+  const render_statistics& renderer::get_statistics () const {
+    return m_statistics;
   }
 
   const glm::vec4& renderer::get_clear_color () const {
@@ -47,4 +306,50 @@ namespace gl {
     glViewport(x, y, width, height);
   }
 
+  // The buffers of draw_queue and what it can use of the context, once there
+  // is one
+  void renderer::create_draw_buffers () {
+    m_draw_buffer = std::make_unique <texture_buffer> ();
+
+    // At least 65536 texels
+    i32 max_texels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+    m_max_draws = std::max <u32> (max_texels / draw_data_texels, 1);
+
+    m_multi_draw = GLAD_GL_VERSION_4_3 and has_extension("GL_ARB_shader_draw_parameters");
+    m_stencil_export = has_extension("GL_ARB_shader_stencil_export");
+
+    if (m_multi_draw)
+      m_indirect_buffer = std::make_unique <indirect_buffer> ();
+  }
+
+  // Whether b can be drawn in the same multi draw as a, which is drawn right
+  // before it. Without stencil export a multi draw has one stencil value
+  bool renderer::can_share_draw (const draw_packet &a, const draw_packet &b) const {
+    return a.m_pass == b.m_pass
+      and a.m_program == b.m_program
+      and a.m_vertex_array == b.m_vertex_array
+      and a.m_index_buffer == b.m_index_buffer
+      and b.m_instance_count == 0
+      and (m_stencil_export or a.m_stencil_ref == b.m_stencil_ref);
+  }
+
+  // Counts a state change as issued or redundant, returns whether it has to
+  // reach the GL
+  bool renderer::count_state_change (bool changed) {
+    ++(changed ? m_statistics.m_state_changes : m_statistics.m_redundant_changes);
+    return changed;
+  }
+
+  bool has_extension (const char *name) {
+    i32 count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+    for (i32 i = 0; i < count; ++i)
+      if (std::strcmp(reinterpret_cast <const char*> (glGetStringi(GL_EXTENSIONS, i)), name) == 0)
+        return true;
+
+    return false;
+  }
+
 } // namespace gl
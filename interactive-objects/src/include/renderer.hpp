@@ -1,11 +1,19 @@
 #ifndef HEADER_RENDERER_H
 #define HEADER_RENDERER_H
 
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 #include <glm/glm.hpp>
 
 #include "vertex/vertex_array.hpp"
 #include "vertex/index_buffer.hpp"
+#include "vertex/indirect_buffer.hpp"
 #include "shader/shader.hpp"
+#include "shader/texture_buffer.hpp"
+#include "render_queue.hpp"
+#include "profiler.hpp"
 
 namespace gl {
 
@@ -25,17 +33,87 @@ namespace gl {
     triangle_strip_adjacency = GL_TRIANGLE_STRIP_ADJACENCY
   };
 
+  // What went through the renderer's state cache since begin_frame
+  struct render_statistics {
+    u32 m_draw_calls;
+
+    // State changes issued to the GL, and those filtered out because the
+    // state was already set
+    u32 m_state_changes;
+    u32 m_redundant_changes;
+  };
+
   class renderer {
     private:
+      // Shadow of the GL state set through the renderer. `unknown_state`
+      // never matches, so the next change goes through
+      static constexpr u32 unknown_state = ~0u;
+
+      struct state_cache {
+        u32 m_program;
+        u32 m_vertex_array;
+        u32 m_index_buffer;
+        u32 m_polygon_mode;
+        u32 m_stencil_write_mask;
+        u32 m_stencil_func;
+        u32 m_stencil_ref;
+        u32 m_stencil_mask;
+        f32 m_line_width;
+        std::unordered_map <u32, bool> m_capabilities;
+      };
+
       glm::vec4 m_clear_color;
       draw_mode m_draw_mode;
 
+      state_cache m_state;
+      render_statistics m_statistics;
+
+      // Per draw data and multi draw commands of draw_queue, see
+      // draw_program. Created with the first queue, the renderer exists
+      // before the GL context
+      std::vector <glm::vec4> m_draw_data;
+      std::unique_ptr <texture_buffer> m_draw_buffer;
+      std::vector <draw_command> m_draw_commands;
+      std::unique_ptr <indirect_buffer> m_indirect_buffer;
+
+      // What the context supports, queried with the first queue. A queue of
+      // more draws than the texture buffer holds records for is drawn in
+      // parts. Multi draws need GL 4.3 and ARB_shader_draw_parameters, with
+      // ARB_shader_stencil_export draws of different stencil values may
+      // share one
+      u32 m_max_draws;
+      bool m_multi_draw;
+      bool m_stencil_export;
+
     public:
       renderer ();
       ~renderer ();
 
+      // Forgets the cached state, which code outside the renderer (buffer
+      // uploads, ImGui) may have changed, and resets the statistics
+      void begin_frame ();
+
       void clear () const;
-      void draw_elements (const vertex_array&, const index_buffer&, const shader_program&) const;
+      void draw_elements (const vertex_array&, const index_buffer&, const shader_program&);
+      void draw_elements (const vertex_array&, const index_buffer&, const shader_program&, u32, u32, i32 = 0);
+      void draw_elements_instanced (const vertex_array&, const index_buffer&, const shader_program&, u32, u32, i32, u32);
+      void draw_elements_indirect (const vertex_array&, const index_buffer&, const shader_program&, u32, u32);
+
+      // Draws the packets of a sorted queue, every pass in a GPU scope of the
+      // profiler if there is one
+      void draw_queue (const render_queue&, profiler* = nullptr);
+
+      void use_program (const shader_program&);
+      void bind_vertex_array (const vertex_array&);
+      void bind_index_buffer (const index_buffer&);
+
+      void set_capability (u32, bool);
+      void set_polygon_mode (u32);
+      void set_stencil_write_mask (u32);
+      void set_stencil_func (u32, i32, u32);
+      void set_line_width (f32);
+
+      const render_statistics& get_statistics () const;
 
       const glm::vec4& get_clear_color () const;
       const draw_mode& get_draw_mode () const;
@@ -43,6 +121,11 @@ namespace gl {
       void set_clear_color (const glm::vec4&);
       void set_draw_mode (const draw_mode&);
       void set_view_port (i32, i32, i32, i32) const;
+
+    private:
+      void create_draw_buffers ();
+      bool can_share_draw (const draw_packet&, const draw_packet&) const;
+      bool count_state_change (bool);
   };
 
 } // namespace gl
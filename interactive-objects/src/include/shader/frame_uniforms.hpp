@@ -0,0 +1,53 @@
+#ifndef HEADER_FRAME_UNIFORMS_H
+#define HEADER_FRAME_UNIFORMS_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "types.hpp"
+#include "shader.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // Mirror of the std140 `frame` uniform block of the shaders, written once
+  // per frame. Every member sits at its std140 offset, which
+  // frame_uniforms_layout lists for shader_program::bind_uniform_block to
+  // check against what the GL compiled
+  struct frame_uniforms {
+    alignas(16) glm::mat4 m_view;
+    alignas(16) glm::mat4 m_projection;
+    alignas(16) glm::mat4 m_view_projection;
+    alignas(16) glm::vec4 m_camera_position;
+    alignas(8) glm::vec2 m_viewport;
+    f32 m_time;
+    f32 m_delta_time;
+  };
+
+  static_assert(offsetof(frame_uniforms, m_view) == 0);
+  static_assert(offsetof(frame_uniforms, m_projection) == 64);
+  static_assert(offsetof(frame_uniforms, m_view_projection) == 128);
+  static_assert(offsetof(frame_uniforms, m_camera_position) == 192);
+  static_assert(offsetof(frame_uniforms, m_viewport) == 208);
+  static_assert(offsetof(frame_uniforms, m_time) == 216);
+  static_assert(offsetof(frame_uniforms, m_delta_time) == 220);
+  static_assert(sizeof(frame_uniforms) == 224);
+
+  static constexpr u32 frame_uniforms_binding = 0;
+
+  inline const std::vector <uniform_block_member> frame_uniforms_layout = {
+    {"u_view", offsetof(frame_uniforms, m_view)},
+    {"u_projection", offsetof(frame_uniforms, m_projection)},
+    {"u_view_projection", offsetof(frame_uniforms, m_view_projection)},
+    {"u_camera_position", offsetof(frame_uniforms, m_camera_position)},
+    {"u_viewport", offsetof(frame_uniforms, m_viewport)},
+    {"u_time", offsetof(frame_uniforms, m_time)},
+    {"u_delta_time", offsetof(frame_uniforms, m_delta_time)}
+  };
+
+} // namespace gl
+
+#endif // HEADER_FRAME_UNIFORMS_H
@@ -0,0 +1,50 @@
+#include <algorithm>
+
+#include "palette_buffer.hpp"
+#include "mesh/mesh_cache.hpp"
+
+namespace gl {
+
+  palette_buffer::palette_buffer ()
+    : m_colors (),
+      m_palettes (),
+      m_buffer (nullptr),
+      m_dirty (false) {
+
+  }
+
+  color_palette palette_buffer::add (const std::vector <glm::vec3> &colors) {
+    u32 size = std::min <u32> (colors.size(), max_palette_size);
+    u64 key = hash_bytes(colors.data(), size * sizeof(glm::vec3));
+
+    if (auto palette = m_palettes.find(key); palette != m_palettes.end())
+      return palette->second;
+
+    color_palette palette {static_cast <u32> (m_colors.size()), size};
+
+    for (u32 i = 0; i < size; ++i)
+      m_colors.emplace_back(colors[i], 1.0f);
+
+    m_palettes[key] = palette;
+    m_dirty = true;
+
+    return palette;
+  }
+
+  void palette_buffer::bind (u32 unit) {
+    if (not m_buffer)
+      m_buffer = std::make_unique <texture_buffer> ();
+
+    if (m_dirty) {
+      m_buffer->update(m_colors.data(), m_colors.size() * sizeof(glm::vec4));
+      m_dirty = false;
+    }
+
+    m_buffer->bind(unit);
+  }
+
+  u32 palette_buffer::get_color_count () const {
+    return m_colors.size();
+  }
+
+} // namespace gl
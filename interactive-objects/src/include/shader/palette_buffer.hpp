@@ -0,0 +1,59 @@
+#ifndef HEADER_PALETTE_BUFFER_H
+#define HEADER_PALETTE_BUFFER_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "types.hpp"
+#include "texture_buffer.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // A range of the colors of a palette_buffer. A palette of size 0 leaves
+  // the vertex colors as they are
+  struct color_palette {
+    u32 m_offset;
+    u32 m_size;
+  };
+
+  // The color palettes of every object in one texture buffer, each stored
+  // once however many objects use it. Vertices of meshes drawn with a
+  // palette keep an index in the red channel of their color instead of a
+  // color, so one mesh serves objects of any palette; the vertex shaders
+  // turn it into entry index % size. Only used from the GL thread
+  class palette_buffer {
+    private:
+      std::vector <glm::vec4> m_colors;
+      std::unordered_map <u64, color_palette> m_palettes;
+
+      // Created by the first bind, the buffer exists before the GL context
+      std::unique_ptr <texture_buffer> m_buffer;
+      bool m_dirty;
+
+    public:
+      // Indices are 8 bit, entries past this many are never drawn
+      static constexpr u32 max_palette_size = 256;
+
+      palette_buffer ();
+
+      palette_buffer (const palette_buffer&) = delete;
+      palette_buffer& operator = (const palette_buffer&) = delete;
+
+      // The palette of these colors, added if no object used it yet
+      color_palette add (const std::vector <glm::vec3>&);
+
+      // Binds the palettes to a texture unit, uploading them first if any
+      // were added since the last bind
+      void bind (u32);
+
+      u32 get_color_count () const;
+  };
+
+} // namespace gl
+
+#endif // HEADER_PALETTE_BUFFER_H
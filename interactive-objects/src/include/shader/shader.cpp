@@ -78,38 +78,162 @@ namespace gl {
     glAttachShader(m_id, s.get_id());
   }
 
-  void shader_program::link () const {
+  void shader_program::link () {
     glLinkProgram(m_id);
+
+    i32 success;
+    glGetProgramiv(m_id, GL_LINK_STATUS, &success);
+
+    if (!success) {
+      char infolog [512];
+      glGetProgramInfoLog(m_id, 512, nullptr, infolog);
+      std::cerr << "Error linking shader program\n" << infolog << std::endl;
+      return;
+    }
+
+    m_uniforms.clear();
+
+    i32 count = 0;
+    i32 max_length = 0;
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+    std::string name (max_length, '\0');
+
+    for (i32 i = 0; i < count; ++i) {
+      i32 length = 0;
+      i32 size = 0;
+      u32 type = 0;
+
+      glGetActiveUniform(m_id, i, max_length, &length, &size, &type, name.data());
+
+      std::string uniform_name (name.data(), length);
+      i32 location = glGetUniformLocation(m_id, uniform_name.c_str());
+
+      // Members of uniform blocks have no location
+      if (location < 0)
+        continue;
+
+      // Arrays are reported as their first element
+      if (uniform_name.ends_with("[0]"))
+        uniform_name.resize(uniform_name.size() - 3);
+
+      m_uniforms[uniform_name] = {location, type};
+    }
   }
 
-  i32 shader_program::get_uniform_location (const std::string& name) {
-    auto location = m_uniform_location.find(name);
+  u32 shader_program::get_id () const {
+    return m_id;
+  }
 
-    if (location != m_uniform_location.end())
-      return location->second;
-    
-    m_uniform_location[name] = glGetUniformLocation(m_id, name.c_str());
-    return m_uniform_location[name];
+  i32 shader_program::get_uniform_location (const std::string& name) const {
+    auto uniform = m_uniforms.find(name);
+    return uniform != m_uniforms.end() ? uniform->second.m_location : -1;
+  }
+
+  // The GL type of a uniform set from T
+  template <typename T>
+  static constexpr u32 uniform_type = 0;
+
+  template <> constexpr u32 uniform_type <bool> = GL_BOOL;
+  template <> constexpr u32 uniform_type <i32> = GL_INT;
+  template <> constexpr u32 uniform_type <f32> = GL_FLOAT;
+  template <> constexpr u32 uniform_type <glm::vec4> = GL_FLOAT_VEC4;
+  template <> constexpr u32 uniform_type <glm::mat4> = GL_FLOAT_MAT4;
+
+  template <typename T>
+  uniform <T> shader_program::get_uniform (const std::string &name) const {
+    auto active = m_uniforms.find(name);
+
+    if (active == m_uniforms.end()) {
+      std::cerr << "uniform (" << name << ") is not an active uniform of the program" << std::endl;
+      return uniform <T> ();
+    }
+
+    if (active->second.m_type != uniform_type <T>) {
+      std::cerr << "uniform (" << name << ") is of GL type 0x" << std::hex << active->second.m_type << ", expected 0x" << uniform_type <T> << std::dec << std::endl;
+      return uniform <T> ();
+    }
+
+    return uniform <T> (active->second.m_location);
+  }
+
+  template uniform <bool> shader_program::get_uniform (const std::string&) const;
+  template uniform <i32> shader_program::get_uniform (const std::string&) const;
+  template uniform <f32> shader_program::get_uniform (const std::string&) const;
+  template uniform <glm::vec4> shader_program::get_uniform (const std::string&) const;
+  template uniform <glm::mat4> shader_program::get_uniform (const std::string&) const;
+
+  bool shader_program::bind_uniform_block (const std::string &name, u32 binding, u32 size, const std::vector <uniform_block_member> &members) const {
+    u32 block = glGetUniformBlockIndex(m_id, name.c_str());
+
+    if (block == GL_INVALID_INDEX) {
+      std::cerr << "uniform block (" << name << ") not found in the program" << std::endl;
+      return false;
+    }
+
+    i32 block_size = 0;
+    glGetActiveUniformBlockiv(m_id, block, GL_UNIFORM_BLOCK_DATA_SIZE, &block_size);
+
+    if (static_cast <u32> (block_size) != size) {
+      std::cerr << "uniform block (" << name << ") is " << block_size << " bytes, expected " << size << std::endl;
+      return false;
+    }
+
+    for (const auto &member: members) {
+      const char *member_name = member.m_name.c_str();
+      u32 index = GL_INVALID_INDEX;
+      i32 offset = -1;
+
+      glGetUniformIndices(m_id, 1, &member_name, &index);
+
+      if (index != GL_INVALID_INDEX)
+        glGetActiveUniformsiv(m_id, 1, &index, GL_UNIFORM_OFFSET, &offset);
+
+      if (index == GL_INVALID_INDEX or static_cast <u32> (offset) != member.m_offset) {
+        std::cerr << "uniform block (" << name << ") member " << member.m_name << " is at offset " << offset << ", expected " << member.m_offset << std::endl;
+        return false;
+      }
+    }
+
+    glUniformBlockBinding(m_id, block, binding);
+    return true;
   }
 
   template <>
-  void shader_program::set_uniform <bool> (const std::string &name, const bool &value) {
-    glUniform1i(get_uniform_location(name), value);
+  void shader_program::set_uniform <bool> (uniform <bool> u, const bool &value) const {
+    glUniform1i(u.get_location(), value);
   }
 
   template <>
-  void shader_program::set_uniform <f32> (const std::string &name, const f32 &value) {
-    glUniform1f(get_uniform_location(name), value);
+  void shader_program::set_uniform <i32> (uniform <i32> u, const i32 &value) const {
+    glUniform1i(u.get_location(), value);
   }
 
   template <>
-  void shader_program::set_uniform <glm::vec4> (const std::string &name, const glm::vec4 &value) {
-    glUniform4f(get_uniform_location(name), value.x, value.y, value.z, value.w);
+  void shader_program::set_uniform <f32> (uniform <f32> u, const f32 &value) const {
+    glUniform1f(u.get_location(), value);
   }
 
   template <>
-  void shader_program::set_uniform <glm::mat4> (const std::string &name, const glm::mat4 &value) {
-    glUniformMatrix4fv(get_uniform_location(name), 1, GL_FALSE, &value[0][0]);
+  void shader_program::set_uniform <glm::vec4> (uniform <glm::vec4> u, const glm::vec4 &value) const {
+    glUniform4f(u.get_location(), value.x, value.y, value.z, value.w);
   }
 
+  template <>
+  void shader_program::set_uniform <glm::mat4> (uniform <glm::mat4> u, const glm::mat4 &value) const {
+    glUniformMatrix4fv(u.get_location(), 1, GL_FALSE, &value[0][0]);
+  }
+
+  template <typename T>
+  void shader_program::set_uniform (const std::string &name, const T &value) const {
+    set_uniform(uniform <T> (get_uniform_location(name)), value);
+  }
+
+  template void shader_program::set_uniform (const std::string&, const bool&) const;
+  template void shader_program::set_uniform (const std::string&, const i32&) const;
+  template void shader_program::set_uniform (const std::string&, const f32&) const;
+  template void shader_program::set_uniform (const std::string&, const glm::vec4&) const;
+  template void shader_program::set_uniform (const std::string&, const glm::mat4&) const;
+
 } // namespace gl
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "types.hpp"
 
@@ -29,10 +30,38 @@ namespace gl {
       u32 get_id () const;
   };
 
+  // Where the CPU side mirror of a uniform block expects a member
+  struct uniform_block_member {
+    std::string m_name;
+    u32 m_offset;
+  };
+
+  // A uniform of a linked program, resolved once with
+  // shader_program::get_uniform so setting it needs no name lookup. An
+  // invalid handle is ignored by set_uniform, like location -1 by the GL
+  template <typename T>
+  class uniform {
+    private:
+      i32 m_location;
+
+    public:
+      uniform (i32 location = -1) : m_location (location) {}
+
+      i32 get_location () const { return m_location; }
+      bool is_valid () const { return m_location >= 0; }
+  };
+
   class shader_program {
     private:
+      struct active_uniform {
+        i32 m_location;
+        u32 m_type;
+      };
+
       u32 m_id;
-      std::unordered_map <std::string, int> m_uniform_location;
+
+      // Every active uniform outside of a uniform block, filled by link()
+      std::unordered_map <std::string, active_uniform> m_uniforms;
     
     public:
       shader_program ();
@@ -42,12 +71,26 @@ namespace gl {
       void unbind () const;
 
       void add_shader (const shader&) const;
-      void link () const;
+      void link ();
+
+      u32 get_id () const;
+
+      i32 get_uniform_location (const std::string&) const;
 
-      i32 get_uniform_location (const std::string&);
+      // Checks the type of the uniform against T, a missing or mismatched
+      // uniform gives an invalid handle
+      template <typename T>
+      uniform <T> get_uniform (const std::string&) const;
+
+      // Attaches a uniform block to a binding point once its layout matches
+      // the given size and member offsets, see uniform_buffer
+      bool bind_uniform_block (const std::string&, u32, u32, const std::vector <uniform_block_member>&) const;
+
+      template <typename T>
+      void set_uniform (const std::string&, const T&) const;
 
       template <typename T>
-      void set_uniform (const std::string&, const T&);
+      void set_uniform (uniform <T>, const T&) const;
   };
 
 } // namespace gl
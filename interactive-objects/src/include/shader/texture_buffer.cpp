@@ -0,0 +1,47 @@
+#include <algorithm>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "texture_buffer.hpp"
+
+namespace gl {
+
+  texture_buffer::texture_buffer ()
+    : m_buffer (0),
+      m_texture (0),
+      m_capacity (0) {
+    glGenBuffers(1, &m_buffer);
+    glGenTextures(1, &m_texture);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+    glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+
+    glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_buffer);
+  }
+
+  texture_buffer::~texture_buffer () {
+    glDeleteTextures(1, &m_texture);
+    glDeleteBuffers(1, &m_buffer);
+  }
+
+  void texture_buffer::bind (u32 unit) const {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+  }
+
+  void texture_buffer::update (const void *data, u32 size) {
+    glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+
+    // A fresh allocation every time, draws of the previous frame may still
+    // be reading the old one. Keeping the size stable lets the driver
+    // recycle the storage it orphans
+    if (size > m_capacity)
+      m_capacity = std::max(size, 2 * m_capacity);
+
+    glBufferData(GL_TEXTURE_BUFFER, m_capacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+  }
+
+} // namespace gl
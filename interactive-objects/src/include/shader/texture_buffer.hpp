@@ -0,0 +1,34 @@
+#ifndef HEADER_TEXTURE_BUFFER_H
+#define HEADER_TEXTURE_BUFFER_H
+
+#include "types.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // A buffer of RGBA32F texels read in shaders through a samplerBuffer with
+  // texelFetch. Rewritten as a whole, it grows to fit what it is given
+  class texture_buffer {
+    private:
+      u32 m_buffer;
+      u32 m_texture;
+      u32 m_capacity;
+
+    public:
+      texture_buffer ();
+      ~texture_buffer ();
+
+      texture_buffer (const texture_buffer&) = delete;
+      texture_buffer& operator = (const texture_buffer&) = delete;
+
+      // Binds the texture to a texture unit
+      void bind (u32) const;
+
+      // Replaces the contents with `size` bytes
+      void update (const void*, u32);
+  };
+
+} // namespace gl
+
+#endif // HEADER_TEXTURE_BUFFER_H
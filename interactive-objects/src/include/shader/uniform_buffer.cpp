@@ -0,0 +1,47 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "uniform_buffer.hpp"
+
+namespace gl {
+
+  uniform_buffer::uniform_buffer (u32 size, u32 binding)
+    : m_id (0),
+      m_size (size),
+      m_binding (binding) {
+    glGenBuffers(1, &m_id);
+    bind();
+    glBufferData(GL_UNIFORM_BUFFER, m_size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_id);
+  }
+
+  uniform_buffer::~uniform_buffer () {
+    glDeleteBuffers(1, &m_id);
+  }
+
+  void uniform_buffer::bind () const {
+    glBindBuffer(GL_UNIFORM_BUFFER, m_id);
+  }
+
+  void uniform_buffer::unbind () const {
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+
+  void uniform_buffer::update (const void *data) const {
+    bind();
+
+    // Orphaning the previous storage lets the driver hand out fresh memory
+    // instead of waiting for draws of the last frame still reading it
+    glBufferData(GL_UNIFORM_BUFFER, m_size, nullptr, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, m_size, data);
+  }
+
+  u32 uniform_buffer::get_size () const {
+    return m_size;
+  }
+
+  u32 uniform_buffer::get_binding () const {
+    return m_binding;
+  }
+
+} // namespace gl
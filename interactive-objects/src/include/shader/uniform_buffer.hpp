@@ -0,0 +1,38 @@
+#ifndef HEADER_UNIFORM_BUFFER_H
+#define HEADER_UNIFORM_BUFFER_H
+
+#include "types.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // A uniform block's storage, bound to a fixed binding point for its whole
+  // lifetime. Programs are attached to the same point with
+  // shader_program::bind_uniform_block
+  class uniform_buffer {
+    private:
+      u32 m_id;
+      u32 m_size;
+      u32 m_binding;
+
+    public:
+      uniform_buffer (u32, u32);
+      ~uniform_buffer ();
+
+      uniform_buffer (const uniform_buffer&) = delete;
+      uniform_buffer& operator = (const uniform_buffer&) = delete;
+
+      void bind () const;
+      void unbind () const;
+
+      // Replaces the whole contents, the size is the one given on creation
+      void update (const void*) const;
+
+      u32 get_size () const;
+      u32 get_binding () const;
+  };
+
+} // namespace gl
+
+#endif // HEADER_UNIFORM_BUFFER_H
@@ -0,0 +1,480 @@
+#if defined(__AVX__)
+  #include <immintrin.h>
+  #define TRANSFORM_LANES 8
+#elif defined(__SSE2__)
+  #include <emmintrin.h>
+  #define TRANSFORM_LANES 4
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+#include "transform_storage.hpp"
+
+namespace gl {
+
+  // The few vector operations integrate and update_matrices need, on the
+  // widest registers the build targets. Without either, the scalar loops do
+  // all the work
+#if defined(__AVX__)
+  using simd_lanes = __m256;
+
+  static inline simd_lanes simd_load (const f32 *p) { return _mm256_loadu_ps(p); }
+  static inline void simd_store (f32 *p, simd_lanes a) { _mm256_storeu_ps(p, a); }
+  static inline simd_lanes simd_splat (f32 a) { return _mm256_set1_ps(a); }
+  static inline simd_lanes simd_add (simd_lanes a, simd_lanes b) { return _mm256_add_ps(a, b); }
+  static inline simd_lanes simd_sub (simd_lanes a, simd_lanes b) { return _mm256_sub_ps(a, b); }
+  static inline simd_lanes simd_mul (simd_lanes a, simd_lanes b) { return _mm256_mul_ps(a, b); }
+  static inline simd_lanes simd_div (simd_lanes a, simd_lanes b) { return _mm256_div_ps(a, b); }
+  static inline simd_lanes simd_sqrt (simd_lanes a) { return _mm256_sqrt_ps(a); }
+  static inline simd_lanes simd_and (simd_lanes a, simd_lanes b) { return _mm256_and_ps(a, b); }
+  static inline simd_lanes simd_or (simd_lanes a, simd_lanes b) { return _mm256_or_ps(a, b); }
+  static inline simd_lanes simd_xor (simd_lanes a, simd_lanes b) { return _mm256_xor_ps(a, b); }
+  static inline simd_lanes simd_less (simd_lanes a, simd_lanes b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+  static inline simd_lanes simd_not_equal (simd_lanes a, simd_lanes b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+  static inline u32 simd_mask (simd_lanes a) { return _mm256_movemask_ps(a); }
+#elif defined(__SSE2__)
+  using simd_lanes = __m128;
+
+  static inline simd_lanes simd_load (const f32 *p) { return _mm_loadu_ps(p); }
+  static inline void simd_store (f32 *p, simd_lanes a) { _mm_storeu_ps(p, a); }
+  static inline simd_lanes simd_splat (f32 a) { return _mm_set1_ps(a); }
+  static inline simd_lanes simd_add (simd_lanes a, simd_lanes b) { return _mm_add_ps(a, b); }
+  static inline simd_lanes simd_sub (simd_lanes a, simd_lanes b) { return _mm_sub_ps(a, b); }
+  static inline simd_lanes simd_mul (simd_lanes a, simd_lanes b) { return _mm_mul_ps(a, b); }
+  static inline simd_lanes simd_div (simd_lanes a, simd_lanes b) { return _mm_div_ps(a, b); }
+  static inline simd_lanes simd_sqrt (simd_lanes a) { return _mm_sqrt_ps(a); }
+  static inline simd_lanes simd_and (simd_lanes a, simd_lanes b) { return _mm_and_ps(a, b); }
+  static inline simd_lanes simd_or (simd_lanes a, simd_lanes b) { return _mm_or_ps(a, b); }
+  static inline simd_lanes simd_xor (simd_lanes a, simd_lanes b) { return _mm_xor_ps(a, b); }
+  static inline simd_lanes simd_less (simd_lanes a, simd_lanes b) { return _mm_cmplt_ps(a, b); }
+  static inline simd_lanes simd_not_equal (simd_lanes a, simd_lanes b) { return _mm_cmpneq_ps(a, b); }
+  static inline u32 simd_mask (simd_lanes a) { return _mm_movemask_ps(a); }
+#endif
+
+  void transform_snapshot::resize (u32 size) {
+    for (auto *component: {
+      &m_position_x, &m_position_y, &m_position_z,
+      &m_orientation_w, &m_orientation_x, &m_orientation_y, &m_orientation_z
+    })
+      component->resize(size);
+  }
+
+  transform_storage::transform_storage ()
+    : m_position_x (),
+      m_position_y (),
+      m_position_z (),
+      m_velocity_x (),
+      m_velocity_y (),
+      m_velocity_z (),
+      m_orientation_w (),
+      m_orientation_x (),
+      m_orientation_y (),
+      m_orientation_z (),
+      m_scale_x (),
+      m_scale_y (),
+      m_scale_z (),
+      m_spin_w (),
+      m_spin_x (),
+      m_spin_y (),
+      m_spin_z (),
+      m_angular_velocity (),
+      m_colliders (),
+      m_matrices (),
+      m_dirty (),
+      m_free () {
+
+  }
+
+  transform_storage& transform_storage::detached () {
+    static transform_storage storage;
+    return storage;
+  }
+
+  void transform_storage::assign (const transform_storage &other) {
+    m_position_x = other.m_position_x;
+    m_position_y = other.m_position_y;
+    m_position_z = other.m_position_z;
+    m_velocity_x = other.m_velocity_x;
+    m_velocity_y = other.m_velocity_y;
+    m_velocity_z = other.m_velocity_z;
+    m_orientation_w = other.m_orientation_w;
+    m_orientation_x = other.m_orientation_x;
+    m_orientation_y = other.m_orientation_y;
+    m_orientation_z = other.m_orientation_z;
+    m_scale_x = other.m_scale_x;
+    m_scale_y = other.m_scale_y;
+    m_scale_z = other.m_scale_z;
+    m_spin_w = other.m_spin_w;
+    m_spin_x = other.m_spin_x;
+    m_spin_y = other.m_spin_y;
+    m_spin_z = other.m_spin_z;
+    m_angular_velocity = other.m_angular_velocity;
+    m_colliders = other.m_colliders;
+    m_matrices = other.m_matrices;
+    m_dirty = other.m_dirty;
+    m_free = other.m_free;
+  }
+
+  u32 transform_storage::add () {
+    u32 index = 0;
+
+    if (not m_free.empty()) {
+      index = m_free.back();
+      m_free.pop_back();
+    }
+    else {
+      index = m_position_x.size();
+
+      for (auto *component: {
+        &m_position_x, &m_position_y, &m_position_z,
+        &m_velocity_x, &m_velocity_y, &m_velocity_z,
+        &m_orientation_w, &m_orientation_x, &m_orientation_y, &m_orientation_z,
+        &m_scale_x, &m_scale_y, &m_scale_z,
+        &m_spin_w, &m_spin_x, &m_spin_y, &m_spin_z
+      })
+        component->push_back(0.0f);
+
+      m_angular_velocity.emplace_back(0.0f);
+      m_colliders.emplace_back(0.0f);
+      m_matrices.emplace_back(1.0f);
+      m_dirty.push_back(0);
+    }
+
+    set_position(index, glm::vec3(0.0f));
+    set_velocity(index, glm::vec3(0.0f));
+    set_orientation(index, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+    set_scale(index, glm::vec3(1.0f));
+    set_angular_velocity(index, glm::vec3(0.0f));
+    set_collider(index, glm::vec4(0.0f));
+
+    return index;
+  }
+
+  u32 transform_storage::add (const transform_storage &other, u32 other_index) {
+    u32 index = add();
+
+    set_position(index, other.get_position(other_index));
+    set_velocity(index, other.get_velocity(other_index));
+    set_orientation(index, other.get_orientation(other_index));
+    set_scale(index, other.get_scale(other_index));
+    set_angular_velocity(index, other.get_angular_velocity(other_index));
+    set_collider(index, other.get_collider(other_index));
+
+    return index;
+  }
+
+  // Free slots are still integrated with the rest, at rest they stay put
+  void transform_storage::remove (u32 index) {
+    set_velocity(index, glm::vec3(0.0f));
+    set_angular_velocity(index, glm::vec3(0.0f));
+    set_collider(index, glm::vec4(0.0f));
+    m_free.push_back(index);
+  }
+
+  void transform_storage::integrate (u32 begin, u32 end, f32 delta_time, const glm::vec3 &lower, const glm::vec3 &upper) {
+    u32 i = begin;
+
+#ifdef TRANSFORM_LANES
+    f32 *positions[3] = {m_position_x.data(), m_position_y.data(), m_position_z.data()};
+    f32 *velocities[3] = {m_velocity_x.data(), m_velocity_y.data(), m_velocity_z.data()};
+
+    const simd_lanes lower_lanes[3] = {simd_splat(lower.x), simd_splat(lower.y), simd_splat(lower.z)};
+    const simd_lanes upper_lanes[3] = {simd_splat(upper.x), simd_splat(upper.y), simd_splat(upper.z)};
+    const simd_lanes delta = simd_splat(delta_time);
+    const simd_lanes sign = simd_splat(-0.0f);
+    const simd_lanes zero = simd_splat(0.0f);
+    const simd_lanes one = simd_splat(1.0f);
+
+    for (; i + TRANSFORM_LANES <= end; i += TRANSFORM_LANES) {
+      simd_lanes moving = zero;
+
+      for (u32 axis = 0; axis < 3; ++axis) {
+        simd_lanes p = simd_load(positions[axis] + i);
+        simd_lanes v = simd_load(velocities[axis] + i);
+
+        // Flips the sign of the lanes outside the bounds
+        simd_lanes outside = simd_or(simd_less(p, lower_lanes[axis]), simd_less(upper_lanes[axis], p));
+        v = simd_xor(v, simd_and(outside, sign));
+        moving = simd_or(moving, simd_not_equal(v, zero));
+
+        simd_store(velocities[axis] + i, v);
+        simd_store(positions[axis] + i, simd_add(p, simd_mul(v, delta)));
+      }
+
+      simd_lanes qw = simd_load(m_orientation_w.data() + i);
+      simd_lanes qx = simd_load(m_orientation_x.data() + i);
+      simd_lanes qy = simd_load(m_orientation_y.data() + i);
+      simd_lanes qz = simd_load(m_orientation_z.data() + i);
+
+      simd_lanes sw = simd_load(m_spin_w.data() + i);
+      simd_lanes sx = simd_load(m_spin_x.data() + i);
+      simd_lanes sy = simd_load(m_spin_y.data() + i);
+      simd_lanes sz = simd_load(m_spin_z.data() + i);
+
+      // A spin with no axis is the identity
+      moving = simd_or(moving, simd_or(simd_not_equal(sx, zero), simd_or(simd_not_equal(sy, zero), simd_not_equal(sz, zero))));
+
+      for (u32 mask = simd_mask(moving), lane = 0; lane < TRANSFORM_LANES; ++lane)
+        m_dirty[i + lane] |= (mask >> lane) & 1;
+
+      // orientation * spin
+      simd_lanes w = simd_sub(simd_sub(simd_sub(simd_mul(qw, sw), simd_mul(qx, sx)), simd_mul(qy, sy)), simd_mul(qz, sz));
+      simd_lanes x = simd_sub(simd_add(simd_add(simd_mul(qw, sx), simd_mul(qx, sw)), simd_mul(qy, sz)), simd_mul(qz, sy));
+      simd_lanes y = simd_add(simd_add(simd_sub(simd_mul(qw, sy), simd_mul(qx, sz)), simd_mul(qy, sw)), simd_mul(qz, sx));
+      simd_lanes z = simd_add(simd_sub(simd_add(simd_mul(qw, sz), simd_mul(qx, sy)), simd_mul(qy, sx)), simd_mul(qz, sw));
+
+      // Normalized every step, so rounding errors do not add up
+      simd_lanes length = simd_sqrt(simd_add(simd_add(simd_mul(w, w), simd_mul(x, x)), simd_add(simd_mul(y, y), simd_mul(z, z))));
+      simd_lanes inverse_length = simd_div(one, length);
+
+      simd_store(m_orientation_w.data() + i, simd_mul(w, inverse_length));
+      simd_store(m_orientation_x.data() + i, simd_mul(x, inverse_length));
+      simd_store(m_orientation_y.data() + i, simd_mul(y, inverse_length));
+      simd_store(m_orientation_z.data() + i, simd_mul(z, inverse_length));
+    }
+#endif
+
+    integrate_scalar(i, end, delta_time, lower, upper);
+  }
+
+  void transform_storage::update_matrices (u32 begin, u32 end) {
+    u32 i = begin;
+
+#ifdef TRANSFORM_LANES
+    const simd_lanes one = simd_splat(1.0f);
+    const simd_lanes two = simd_splat(2.0f);
+
+    for (; i + TRANSFORM_LANES <= end; i += TRANSFORM_LANES) {
+      bool dirty = false;
+
+      for (u32 lane = 0; lane < TRANSFORM_LANES; ++lane)
+        dirty |= m_dirty[i + lane] != 0;
+
+      // Scenes at rest skip almost everything
+      if (not dirty)
+        continue;
+
+      simd_lanes w = simd_load(m_orientation_w.data() + i);
+      simd_lanes x = simd_load(m_orientation_x.data() + i);
+      simd_lanes y = simd_load(m_orientation_y.data() + i);
+      simd_lanes z = simd_load(m_orientation_z.data() + i);
+
+      simd_lanes sx = simd_load(m_scale_x.data() + i);
+      simd_lanes sy = simd_load(m_scale_y.data() + i);
+      simd_lanes sz = simd_load(m_scale_z.data() + i);
+
+      simd_lanes xx = simd_mul(x, x), yy = simd_mul(y, y), zz = simd_mul(z, z);
+      simd_lanes xy = simd_mul(x, y), xz = simd_mul(x, z), yz = simd_mul(y, z);
+      simd_lanes wx = simd_mul(w, x), wy = simd_mul(w, y), wz = simd_mul(w, z);
+
+      // The upper 3x3 of rotate * scale, column by column
+      alignas(32) f32 columns[9][TRANSFORM_LANES];
+
+      simd_store(columns[0], simd_mul(simd_sub(one, simd_mul(two, simd_add(yy, zz))), sx));
+      simd_store(columns[1], simd_mul(simd_mul(two, simd_add(xy, wz)), sx));
+      simd_store(columns[2], simd_mul(simd_mul(two, simd_sub(xz, wy)), sx));
+
+      simd_store(columns[3], simd_mul(simd_mul(two, simd_sub(xy, wz)), sy));
+      simd_store(columns[4], simd_mul(simd_sub(one, simd_mul(two, simd_add(xx, zz))), sy));
+      simd_store(columns[5], simd_mul(simd_mul(two, simd_add(yz, wx)), sy));
+
+      simd_store(columns[6], simd_mul(simd_mul(two, simd_add(xz, wy)), sz));
+      simd_store(columns[7], simd_mul(simd_mul(two, simd_sub(yz, wx)), sz));
+      simd_store(columns[8], simd_mul(simd_sub(one, simd_mul(two, simd_add(xx, yy))), sz));
+
+      for (u32 lane = 0; lane < TRANSFORM_LANES; ++lane) {
+        u32 index = i + lane;
+
+        if (not m_dirty[index])
+          continue;
+
+        m_matrices[index] = glm::mat4(
+          glm::vec4(columns[0][lane], columns[1][lane], columns[2][lane], 0.0f),
+          glm::vec4(columns[3][lane], columns[4][lane], columns[5][lane], 0.0f),
+          glm::vec4(columns[6][lane], columns[7][lane], columns[8][lane], 0.0f),
+          glm::vec4(m_position_x[index], m_position_y[index], m_position_z[index], 1.0f)
+        );
+
+        m_dirty[index] = 0;
+      }
+    }
+#endif
+
+    for (; i < end; ++i)
+      if (m_dirty[i])
+        update_matrix(i);
+  }
+
+  void transform_storage::save (u32 begin, u32 end, transform_snapshot &snapshot) const {
+    std::copy(m_position_x.begin() + begin, m_position_x.begin() + end, snapshot.m_position_x.begin() + begin);
+    std::copy(m_position_y.begin() + begin, m_position_y.begin() + end, snapshot.m_position_y.begin() + begin);
+    std::copy(m_position_z.begin() + begin, m_position_z.begin() + end, snapshot.m_position_z.begin() + begin);
+    std::copy(m_orientation_w.begin() + begin, m_orientation_w.begin() + end, snapshot.m_orientation_w.begin() + begin);
+    std::copy(m_orientation_x.begin() + begin, m_orientation_x.begin() + end, snapshot.m_orientation_x.begin() + begin);
+    std::copy(m_orientation_y.begin() + begin, m_orientation_y.begin() + end, snapshot.m_orientation_y.begin() + begin);
+    std::copy(m_orientation_z.begin() + begin, m_orientation_z.begin() + end, snapshot.m_orientation_z.begin() + begin);
+  }
+
+  // Plain loops over the arrays, which the compiler vectorizes on its own.
+  // Normalizing the blended quaternion (nlerp) is close enough to slerp for
+  // the few degrees a tick turns
+  void transform_storage::interpolate (u32 begin, u32 end, const transform_snapshot &from, const transform_snapshot &to, f32 alpha) {
+    for (u32 i = begin; i < end; ++i) {
+      f32 x = from.m_position_x[i] + (to.m_position_x[i] - from.m_position_x[i]) * alpha;
+      f32 y = from.m_position_y[i] + (to.m_position_y[i] - from.m_position_y[i]) * alpha;
+      f32 z = from.m_position_z[i] + (to.m_position_z[i] - from.m_position_z[i]) * alpha;
+
+      f32 dot = from.m_orientation_w[i] * to.m_orientation_w[i] + from.m_orientation_x[i] * to.m_orientation_x[i]
+        + from.m_orientation_y[i] * to.m_orientation_y[i] + from.m_orientation_z[i] * to.m_orientation_z[i];
+      f32 sign = dot < 0.0f ? -1.0f : 1.0f;
+
+      f32 qw = from.m_orientation_w[i] + (sign * to.m_orientation_w[i] - from.m_orientation_w[i]) * alpha;
+      f32 qx = from.m_orientation_x[i] + (sign * to.m_orientation_x[i] - from.m_orientation_x[i]) * alpha;
+      f32 qy = from.m_orientation_y[i] + (sign * to.m_orientation_y[i] - from.m_orientation_y[i]) * alpha;
+      f32 qz = from.m_orientation_z[i] + (sign * to.m_orientation_z[i] - from.m_orientation_z[i]) * alpha;
+      f32 length = std::sqrt(qw * qw + qx * qx + qy * qy + qz * qz);
+
+      qw /= length;
+      qx /= length;
+      qy /= length;
+      qz /= length;
+
+      bool moved = x != m_position_x[i] or y != m_position_y[i] or z != m_position_z[i]
+        or qw != m_orientation_w[i] or qx != m_orientation_x[i] or qy != m_orientation_y[i] or qz != m_orientation_z[i];
+
+      if (not moved)
+        continue;
+
+      m_position_x[i] = x;
+      m_position_y[i] = y;
+      m_position_z[i] = z;
+      m_orientation_w[i] = qw;
+      m_orientation_x[i] = qx;
+      m_orientation_y[i] = qy;
+      m_orientation_z[i] = qz;
+      m_dirty[i] = 1;
+    }
+  }
+
+  glm::vec3 transform_storage::get_position (u32 index) const {
+    return {m_position_x[index], m_position_y[index], m_position_z[index]};
+  }
+
+  glm::vec3 transform_storage::get_velocity (u32 index) const {
+    return {m_velocity_x[index], m_velocity_y[index], m_velocity_z[index]};
+  }
+
+  glm::vec3 transform_storage::get_angular_velocity (u32 index) const {
+    return m_angular_velocity[index];
+  }
+
+  glm::quat transform_storage::get_orientation (u32 index) const {
+    return glm::quat(m_orientation_w[index], m_orientation_x[index], m_orientation_y[index], m_orientation_z[index]);
+  }
+
+  glm::vec3 transform_storage::get_scale (u32 index) const {
+    return {m_scale_x[index], m_scale_y[index], m_scale_z[index]};
+  }
+
+  const glm::mat4& transform_storage::get_matrix (u32 index) const {
+    if (m_dirty[index])
+      update_matrix(index);
+
+    return m_matrices[index];
+  }
+
+  const glm::vec4& transform_storage::get_collider (u32 index) const {
+    return m_colliders[index];
+  }
+
+  glm::vec4 transform_storage::get_world_collider (u32 index) const {
+    const glm::vec4 &collider = m_colliders[index];
+    glm::vec3 scale = glm::abs(get_scale(index));
+    glm::vec3 center = get_position(index) + get_orientation(index) * (glm::vec3(collider) * scale);
+
+    return glm::vec4(center, collider.w * std::max({scale.x, scale.y, scale.z}));
+  }
+
+  void transform_storage::set_position (u32 index, const glm::vec3 &position) {
+    m_position_x[index] = position.x;
+    m_position_y[index] = position.y;
+    m_position_z[index] = position.z;
+    m_dirty[index] = 1;
+  }
+
+  void transform_storage::set_velocity (u32 index, const glm::vec3 &velocity) {
+    m_velocity_x[index] = velocity.x;
+    m_velocity_y[index] = velocity.y;
+    m_velocity_z[index] = velocity.z;
+  }
+
+  void transform_storage::set_angular_velocity (u32 index, const glm::vec3 &angles) {
+    glm::quat spin = glm::angleAxis(glm::radians(angles.x), glm::vec3(1.0f, 0.0f, 0.0f))
+      * glm::angleAxis(glm::radians(angles.y), glm::vec3(0.0f, 1.0f, 0.0f))
+      * glm::angleAxis(glm::radians(angles.z), glm::vec3(0.0f, 0.0f, 1.0f));
+
+    m_angular_velocity[index] = angles;
+    m_spin_w[index] = spin.w;
+    m_spin_x[index] = spin.x;
+    m_spin_y[index] = spin.y;
+    m_spin_z[index] = spin.z;
+  }
+
+  void transform_storage::set_orientation (u32 index, const glm::quat &orientation) {
+    m_orientation_w[index] = orientation.w;
+    m_orientation_x[index] = orientation.x;
+    m_orientation_y[index] = orientation.y;
+    m_orientation_z[index] = orientation.z;
+    m_dirty[index] = 1;
+  }
+
+  void transform_storage::set_scale (u32 index, const glm::vec3 &scale) {
+    m_scale_x[index] = scale.x;
+    m_scale_y[index] = scale.y;
+    m_scale_z[index] = scale.z;
+    m_dirty[index] = 1;
+  }
+
+  void transform_storage::set_collider (u32 index, const glm::vec4 &collider) {
+    m_colliders[index] = collider;
+  }
+
+  u32 transform_storage::get_size () const {
+    return m_position_x.size();
+  }
+
+  // The slots of [begin, end) one at a time, the same steps as integrate
+  void transform_storage::integrate_scalar (u32 begin, u32 end, f32 delta_time, const glm::vec3 &lower, const glm::vec3 &upper) {
+    for (u32 i = begin; i < end; ++i) {
+      glm::vec3 position = get_position(i);
+      glm::vec3 velocity = get_velocity(i);
+
+      for (u32 axis = 0; axis < 3; ++axis)
+        if (position[axis] < lower[axis] or upper[axis] < position[axis])
+          velocity[axis] = -velocity[axis];
+
+      glm::quat spin (m_spin_w[i], m_spin_x[i], m_spin_y[i], m_spin_z[i]);
+
+      if (velocity == glm::vec3(0.0f) and spin.x == 0.0f and spin.y == 0.0f and spin.z == 0.0f)
+        continue;
+
+      set_velocity(i, velocity);
+      set_position(i, position + velocity * delta_time);
+      set_orientation(i, glm::normalize(get_orientation(i) * spin));
+    }
+  }
+
+  void transform_storage::update_matrix (u32 index) const {
+    glm::mat4 matrix = glm::mat4_cast(get_orientation(index));
+
+    matrix[0] *= m_scale_x[index];
+    matrix[1] *= m_scale_y[index];
+    matrix[2] *= m_scale_z[index];
+    matrix[3] = glm::vec4(get_position(index), 1.0f);
+
+    m_matrices[index] = matrix;
+    m_dirty[index] = 0;
+  }
+
+} // namespace gl
@@ -0,0 +1,151 @@
+#ifndef HEADER_TRANSFORM_STORAGE_H
+#define HEADER_TRANSFORM_STORAGE_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "types.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // Where every slot of a storage was at the end of one simulation tick,
+  // see transform_storage::save and interpolate
+  struct transform_snapshot {
+    u64 m_tick;
+
+    std::vector <f32> m_position_x;
+    std::vector <f32> m_position_y;
+    std::vector <f32> m_position_z;
+
+    std::vector <f32> m_orientation_w;
+    std::vector <f32> m_orientation_x;
+    std::vector <f32> m_orientation_y;
+    std::vector <f32> m_orientation_z;
+
+    void resize (u32);
+  };
+
+  // The transforms and simulation state of many objects as a structure of
+  // arrays, one array per component, indexed by slot. integrate only streams
+  // through the arrays it needs, 4 (SSE) or 8 (AVX) slots at a time.
+  //
+  // A transform is a position, an orientation and a scale. Its matrix,
+  // translate * rotate * scale, is cached per slot and rebuilt only after the
+  // slot changed: update_matrices rebuilds every changed slot in one pass,
+  // get_matrix the one slot it is asked for when that pass has not run yet.
+  //
+  // Angular velocities are Euler angles in degrees applied every step, X
+  // then Y then Z in the object's frame. They are kept as the quaternion one
+  // step rotates by, so a step is one quaternion product per slot
+  class transform_storage {
+    private:
+      std::vector <f32> m_position_x;
+      std::vector <f32> m_position_y;
+      std::vector <f32> m_position_z;
+
+      std::vector <f32> m_velocity_x;
+      std::vector <f32> m_velocity_y;
+      std::vector <f32> m_velocity_z;
+
+      std::vector <f32> m_orientation_w;
+      std::vector <f32> m_orientation_x;
+      std::vector <f32> m_orientation_y;
+      std::vector <f32> m_orientation_z;
+
+      std::vector <f32> m_scale_x;
+      std::vector <f32> m_scale_y;
+      std::vector <f32> m_scale_z;
+
+      std::vector <f32> m_spin_w;
+      std::vector <f32> m_spin_x;
+      std::vector <f32> m_spin_y;
+      std::vector <f32> m_spin_z;
+
+      // As set, the spin quaternion is what integrate reads
+      std::vector <glm::vec3> m_angular_velocity;
+
+      // Object space sphere (center, radius) a slot collides with others by,
+      // radius 0 for slots that do not collide
+      std::vector <glm::vec4> m_colliders;
+
+      // Filled in on demand by get_matrix, hence mutable
+      mutable std::vector <glm::mat4> m_matrices;
+      mutable std::vector <u8> m_dirty;
+
+      // Slots removed and not reused yet, they hold a resting identity
+      std::vector <u32> m_free;
+
+    public:
+      transform_storage ();
+
+      transform_storage (const transform_storage&) = delete;
+      transform_storage& operator = (const transform_storage&) = delete;
+
+      // Objects not part of a scene yet keep their state here
+      static transform_storage& detached ();
+
+      // Becomes a copy of `other`, slot for slot
+      void assign (const transform_storage&);
+
+      // A slot at the origin, at rest, with the identity orientation and scale
+      // and no collider
+      u32 add ();
+
+      // A slot with the state of `index` in `other`
+      u32 add (const transform_storage&, u32);
+      void remove (u32);
+
+      // Moves the slots of [begin, end) by their velocity over `delta_time`
+      // and turns them by their angular velocity. A velocity component flips
+      // while the position is outside [lower, upper] on that axis. Only slots
+      // that move are marked as changed. Disjoint ranges may be integrated
+      // on different threads, best starting at multiples of 8
+      void integrate (u32, u32, f32, const glm::vec3&, const glm::vec3&);
+
+      // Rebuilds the matrix of every slot of [begin, end) changed since it was
+      // last built, on any thread like integrate
+      void update_matrices (u32, u32);
+
+      // Copies the positions and orientations of [begin, end) into a
+      // snapshot at least as large as the storage
+      void save (u32, u32, transform_snapshot&) const;
+
+      // Places the slots of [begin, end) `alpha` of the way from one snapshot
+      // to the next: positions are blended linearly, orientations along the
+      // shorter arc and normalized. Only slots that move are marked changed
+      void interpolate (u32, u32, const transform_snapshot&, const transform_snapshot&, f32);
+
+      glm::vec3 get_position (u32) const;
+      glm::vec3 get_velocity (u32) const;
+      glm::vec3 get_angular_velocity (u32) const;
+      glm::quat get_orientation (u32) const;
+      glm::vec3 get_scale (u32) const;
+      const glm::mat4& get_matrix (u32) const;
+      const glm::vec4& get_collider (u32) const;
+
+      // The collider moved, turned and scaled with the slot, as (center,
+      // radius) in world space. Non-uniform scales take the largest factor
+      glm::vec4 get_world_collider (u32) const;
+
+      void set_position (u32, const glm::vec3&);
+      void set_velocity (u32, const glm::vec3&);
+      void set_angular_velocity (u32, const glm::vec3&);
+      void set_orientation (u32, const glm::quat&);
+      void set_scale (u32, const glm::vec3&);
+      void set_collider (u32, const glm::vec4&);
+
+      // Slots in use and free
+      u32 get_size () const;
+
+    private:
+      void integrate_scalar (u32, u32, f32, const glm::vec3&, const glm::vec3&);
+      void update_matrix (u32) const;
+  };
+
+} // namespace gl
+
+#endif // HEADER_TRANSFORM_STORAGE_H
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <vector>
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -7,12 +10,40 @@ namespace gl {
 
   index_buffer::index_buffer (const u32 *data, u32 count)
     : m_id (0),
-      m_count (count) {
+      m_count (count),
+      m_type (GL_UNSIGNED_INT) {
     glGenBuffers(1, &m_id);
     bind();
+
+    if (m_count > 0 and *std::max_element(data, data + m_count) <= 0xffff) {
+      std::vector <u16> narrow (data, data + m_count);
+
+      m_type = GL_UNSIGNED_SHORT;
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_count * sizeof(u16), narrow.data(), GL_STATIC_DRAW);
+      return;
+    }
+
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_count * sizeof(u32), data, GL_STATIC_DRAW);
   }
 
+  index_buffer::index_buffer (const u16 *data, u32 count)
+    : m_id (0),
+      m_count (count),
+      m_type (GL_UNSIGNED_SHORT) {
+    glGenBuffers(1, &m_id);
+    bind();
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_count * sizeof(u16), data, GL_STATIC_DRAW);
+  }
+
+  index_buffer::index_buffer (u32 type, u32 count)
+    : m_id (0),
+      m_count (count),
+      m_type (type) {
+    glGenBuffers(1, &m_id);
+    bind();
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_count * get_type_size(), nullptr, GL_STATIC_DRAW);
+  }
+
   index_buffer::~index_buffer () {
     glDeleteBuffers(1, &m_id);
   }
@@ -25,8 +56,26 @@ namespace gl {
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
   }
 
+  void index_buffer::update (u32 first, const void *data, u32 count) const {
+    bind();
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, first * get_type_size(), count * get_type_size(), data);
+  }
+
+  u32 index_buffer::get_id () const {
+    return m_id;
+  }
+
   u32 index_buffer::get_count () const {
     return m_count;
   }
 
+  // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, for glDrawElements
+  u32 index_buffer::get_type () const {
+    return m_type;
+  }
+
+  u32 index_buffer::get_type_size () const {
+    return m_type == GL_UNSIGNED_SHORT ? sizeof(u16) : sizeof(u32);
+  }
+
 } // namespace gl
@@ -11,15 +11,27 @@ namespace gl {
     private:
       u32 m_id;
       u32 m_count;
+      u32 m_type;
 
     public:
+      // Indices that all fit in 16 bits are uploaded as GL_UNSIGNED_SHORT
       index_buffer (const u32*, u32);
+      index_buffer (const u16*, u32);
+
+      // Uninitialised storage for `count` indices of a type, see update
+      index_buffer (u32, u32);
       ~index_buffer ();
 
       void bind () const;
       void unbind () const;
 
+      // Writes `count` indices of the buffer's type starting at index `first`
+      void update (u32, const void*, u32) const;
+
+      u32 get_id () const;
       u32 get_count () const;
+      u32 get_type () const;
+      u32 get_type_size () const;
   };
 
 } // namespace gl
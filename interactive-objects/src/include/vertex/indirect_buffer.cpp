@@ -0,0 +1,37 @@
+#include <algorithm>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "indirect_buffer.hpp"
+
+namespace gl {
+
+  indirect_buffer::indirect_buffer ()
+    : m_id (0),
+      m_capacity (0) {
+    glGenBuffers(1, &m_id);
+  }
+
+  indirect_buffer::~indirect_buffer () {
+    glDeleteBuffers(1, &m_id);
+  }
+
+  void indirect_buffer::bind () const {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_id);
+  }
+
+  void indirect_buffer::update (const draw_command *commands, u32 count) {
+    u32 size = count * sizeof(draw_command);
+    bind();
+
+    // Orphaned like texture_buffer, the draws of the previous frame may
+    // still be reading the old commands
+    if (size > m_capacity)
+      m_capacity = std::max(size, 2 * m_capacity);
+
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, m_capacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, commands);
+  }
+
+} // namespace gl
@@ -0,0 +1,41 @@
+#ifndef HEADER_INDIRECT_BUFFER_H
+#define HEADER_INDIRECT_BUFFER_H
+
+#include "types.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // One draw of glMultiDrawElementsIndirect, laid out as the GL reads it
+  struct draw_command {
+    u32 m_count;
+    u32 m_instance_count;
+    u32 m_first_index;
+    i32 m_base_vertex;
+    u32 m_base_instance;
+  };
+
+  // The draw commands of glMultiDrawElementsIndirect (GL 4.3). Rewritten as
+  // a whole, it grows to fit what it is given
+  class indirect_buffer {
+    private:
+      u32 m_id;
+      u32 m_capacity;
+
+    public:
+      indirect_buffer ();
+      ~indirect_buffer ();
+
+      indirect_buffer (const indirect_buffer&) = delete;
+      indirect_buffer& operator = (const indirect_buffer&) = delete;
+
+      void bind () const;
+
+      // Replaces the contents with `count` commands
+      void update (const draw_command*, u32);
+  };
+
+} // namespace gl
+
+#endif // HEADER_INDIRECT_BUFFER_H
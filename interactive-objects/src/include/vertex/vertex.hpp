@@ -6,5 +6,6 @@
 #include "vertex_buffer.hpp"
 #include "vertex_buffer_layout.hpp"
 #include "index_buffer.hpp"
+#include "vertex_format.hpp"
 
 #endif // HEADER_VERTEX_VERTEX_H
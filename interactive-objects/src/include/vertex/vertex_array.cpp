@@ -22,7 +22,11 @@ namespace gl {
     glBindVertexArray(0);
   }
 
-  void vertex_array::add_buffer (const vertex_buffer& vb, const vertex_buffer_layout& layout) {
+  u32 vertex_array::get_id () const {
+    return m_id;
+  }
+
+  void vertex_array::add_buffer (const vertex_buffer& vb, const vertex_buffer_layout& layout, u32 first_location) {
     bind();
     vb.bind();
 
@@ -30,12 +34,14 @@ namespace gl {
 
     for (u32 i = 0, offset = 0; i < elements.size(); ++i) {
       const auto &element = elements[i];
+      u32 location = first_location + i;
       
-      glEnableVertexAttribArray(i);
+      glEnableVertexAttribArray(location);
       glVertexAttribPointer(
-        i, element.get_count(), element.get_type(), element.get_normalised(),
+        location, element.get_count(), element.get_type(), element.get_normalised(),
         layout.get_stride(), (const void*)static_cast <std::uintptr_t> (offset)
       );
+      glVertexAttribDivisor(location, layout.get_divisor());
       
       offset += vertex_buffer_element::get_size_of_type(element.get_type()) * element.get_count();
     }
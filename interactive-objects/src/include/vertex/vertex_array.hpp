@@ -20,7 +20,11 @@ namespace gl {
       void bind () const;
       void unbind () const;
 
-      void add_buffer (const vertex_buffer&, const vertex_buffer_layout&);
+      u32 get_id () const;
+
+      // Attributes of the layout are numbered from the given location on, so
+      // several buffers (e.g. vertices and instances) can feed one array
+      void add_buffer (const vertex_buffer&, const vertex_buffer_layout&, u32 = 0);
   };
 
 } // namespace gl
@@ -5,11 +5,13 @@
 
 namespace gl {
 
-  vertex_buffer::vertex_buffer (const void *data, u32 size)
+  static u32 get_usage (buffer_usage);
+
+  vertex_buffer::vertex_buffer (const void *data, u32 size, buffer_usage usage)
     : m_id (0) {
     glGenBuffers(1, &m_id);
     bind();
-    glBufferData(GL_ARRAY_BUFFER, size, data, GL_DYNAMIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, size, data, get_usage(usage));
   }
 
   vertex_buffer::~vertex_buffer () {
@@ -24,4 +26,26 @@ namespace gl {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
   }
 
+  void vertex_buffer::update (u32 offset, const void *data, u32 size) const {
+    bind();
+    glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+  }
+
+  void vertex_buffer::orphan (u32 size, buffer_usage usage) const {
+    bind();
+    glBufferData(GL_ARRAY_BUFFER, size, nullptr, get_usage(usage));
+  }
+
+  u32 vertex_buffer::get_id () const {
+    return m_id;
+  }
+
+  u32 get_usage (buffer_usage usage) {
+    switch (usage) {
+      case buffer_usage::dynamic_draw: return GL_DYNAMIC_DRAW;
+      case buffer_usage::stream_draw: return GL_STREAM_DRAW;
+      default: return GL_STATIC_DRAW;
+    }
+  }
+
 } // namespace gl
@@ -7,16 +7,34 @@ namespace gl {
 
   using namespace gl::types;
 
+  // How often the contents of a buffer change, a hint for where the driver
+  // keeps it
+  enum class buffer_usage {
+    static_draw,
+    dynamic_draw,
+    stream_draw
+  };
+
   class vertex_buffer {
     private:
       u32 m_id;
 
     public:
-      vertex_buffer (const void*, u32);
+      vertex_buffer (const void*, u32, buffer_usage = buffer_usage::static_draw);
       ~vertex_buffer ();
 
       void bind () const;
       void unbind () const;
+
+      // Writes `size` bytes at byte `offset`
+      void update (u32, const void*, u32) const;
+
+      // Swaps the storage for a fresh, undefined one of `size` bytes. Draws
+      // still reading the old storage keep it, so writing the new one right
+      // after does not wait for them
+      void orphan (u32, buffer_usage) const;
+
+      u32 get_id () const;
   };
 
 } // namespace gl
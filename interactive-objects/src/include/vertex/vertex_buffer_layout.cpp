@@ -18,9 +18,12 @@ namespace gl {
 
   u32 vertex_buffer_element::get_size_of_type (u32 type) {
     switch (type) {
-      case GL_FLOAT:         return sizeof(f32);
-      case GL_UNSIGNED_INT:  return sizeof(u32);
-      case GL_UNSIGNED_BYTE: return sizeof(byte);
+      case GL_FLOAT:          return sizeof(f32);
+      case GL_HALF_FLOAT:     return sizeof(f16);
+      case GL_UNSIGNED_INT:   return sizeof(u32);
+      case GL_SHORT:          return sizeof(i16);
+      case GL_UNSIGNED_SHORT: return sizeof(u16);
+      case GL_UNSIGNED_BYTE:  return sizeof(byte);
     }
 
     // TODO: add exception if not these types
@@ -39,9 +42,10 @@ namespace gl {
     return m_normalised;
   }
 
-  vertex_buffer_layout::vertex_buffer_layout () 
+  vertex_buffer_layout::vertex_buffer_layout (u32 divisor)
     : m_elements (),
-      m_stride (0)
+      m_stride (0),
+      m_divisor (divisor)
   { }
 
   vertex_buffer_layout::~vertex_buffer_layout ()
@@ -64,6 +68,20 @@ namespace gl {
     m_stride += count * vertex_buffer_element::get_size_of_type(GL_UNSIGNED_INT);
   }
 
+  template <>
+  void vertex_buffer_layout::push <f16> (u32 count) {
+    m_elements.push_back({GL_HALF_FLOAT, count, GL_FALSE});
+    m_stride += count * vertex_buffer_element::get_size_of_type(GL_HALF_FLOAT);
+  }
+
+  // Signed shorts are always normalised to [-1, 1], they only hold quantized
+  // data (see vertex_format)
+  template <>
+  void vertex_buffer_layout::push <i16> (u32 count) {
+    m_elements.push_back({GL_SHORT, count, GL_TRUE});
+    m_stride += count * vertex_buffer_element::get_size_of_type(GL_SHORT);
+  }
+
   template <>
   void vertex_buffer_layout::push <byte> (u32 count) {
     m_elements.push_back({GL_UNSIGNED_BYTE, count, GL_TRUE});
@@ -78,4 +96,8 @@ namespace gl {
     return m_stride;
   }
 
+  u32 vertex_buffer_layout::get_divisor () const {
+    return m_divisor;
+  }
+
 } // namespace gl
@@ -32,8 +32,12 @@ namespace gl {
       std::vector <vertex_buffer_element> m_elements;
       u32 m_stride;
 
+      // 0 for per vertex data, otherwise the attributes advance once per
+      // `m_divisor` instances
+      u32 m_divisor;
+
     public:
-      vertex_buffer_layout ();
+      vertex_buffer_layout (u32 = 0);
       ~vertex_buffer_layout ();
 
       template <typename T>
@@ -41,6 +45,7 @@ namespace gl {
 
       const std::vector <vertex_buffer_element>& get_elements () const;
       u32 get_stride () const;
+      u32 get_divisor () const;
   };
 
 } // namespace gl
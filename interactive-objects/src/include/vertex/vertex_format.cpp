@@ -0,0 +1,142 @@
+#include <cmath>
+#include <cstring>
+
+#include <glad/glad.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "vertex_format.hpp"
+
+namespace gl {
+
+  vertex_buffer_layout get_vertex_layout (vertex_format format) {
+    vertex_buffer_layout layout;
+
+    switch (format) {
+      case vertex_format::full:
+        layout.push <f32> (3); // vertex
+        layout.push <f32> (3); // color
+        break;
+
+      case vertex_format::snorm16:
+        layout.push <i16> (4); // vertex, w is padding
+        layout.push <byte> (4); // color
+        break;
+
+      case vertex_format::half:
+        layout.push <f16> (4); // vertex, w is padding
+        layout.push <byte> (4); // color
+        break;
+    }
+
+    return layout;
+  }
+
+  glm::mat4 get_dequantize_matrix (vertex_format format, const bounding_box &bounds) {
+    if (format == vertex_format::full or bounds.is_empty())
+      return glm::mat4(1.0f);
+
+    glm::mat4 dequantize = glm::translate(glm::mat4(1.0f), bounds.get_center());
+    return glm::scale(dequantize, bounds.get_extent());
+  }
+
+  vertex_encoder::vertex_encoder (vertex_format format, const bounding_box &bounds)
+    : m_format (format),
+      m_stride (get_vertex_layout(format).get_stride()),
+      m_center (0.0f),
+      m_inverse_extent (1.0f) {
+
+    if (format == vertex_format::full or bounds.is_empty())
+      return;
+
+    m_center = bounds.get_center();
+
+    // A flat axis has nothing to quantize, every vertex sits on the center
+    glm::vec3 extent = bounds.get_extent();
+
+    for (u32 i = 0; i < 3; ++i)
+      m_inverse_extent[i] = extent[i] > 0.0f ? 1.0f / extent[i] : 0.0f;
+  }
+
+  u32 vertex_encoder::get_stride () const {
+    return m_stride;
+  }
+
+  void vertex_encoder::encode (const glm::vec3 &position, const glm::vec3 &color, byte *out) const {
+    if (m_format == vertex_format::full) {
+      std::memcpy(out, &position, sizeof(glm::vec3));
+      std::memcpy(out + sizeof(glm::vec3), &color, sizeof(glm::vec3));
+      return;
+    }
+
+    glm::vec3 p = (position - m_center) * m_inverse_extent;
+    byte rgba[4] = {to_unorm8(color.r), to_unorm8(color.g), to_unorm8(color.b), 255};
+
+    if (m_format == vertex_format::snorm16) {
+      i16 xyzw[4] = {to_snorm16(p.x), to_snorm16(p.y), to_snorm16(p.z), 0};
+      std::memcpy(out, xyzw, sizeof(xyzw));
+    }
+    else {
+      f16 xyzw[4] = {to_f16(p.x), to_f16(p.y), to_f16(p.z), to_f16(0.0f)};
+      std::memcpy(out, xyzw, sizeof(xyzw));
+    }
+
+    std::memcpy(out + 8, rgba, sizeof(rgba));
+  }
+
+  // GL 3.3 decodes a normalised short c as (2c + 1) / 65535 where newer
+  // versions use c / 32767, the difference is well below a quantization step
+  i16 to_snorm16 (f32 value) {
+    value = std::fmin(std::fmax(value, -1.0f), 1.0f);
+    return static_cast <i16> (std::lround(value * 32767.0f));
+  }
+
+  byte to_unorm8 (f32 value) {
+    value = std::fmin(std::fmax(value, 0.0f), 1.0f);
+    return static_cast <byte> (std::lround(value * 255.0f));
+  }
+
+  // Rounds to nearest (ties away from zero), values too small for a half
+  // become (signed) zero and values too large become infinity
+  f16 to_f16 (f32 value) {
+    u32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    u32 sign = (bits >> 16) & 0x8000;
+    u32 biased_exponent = (bits >> 23) & 0xff;
+    u32 mantissa = bits & 0x7fffff;
+    i32 exponent = static_cast <i32> (biased_exponent) - 127 + 15;
+
+    // infinity and NaN
+    if (biased_exponent == 0xff)
+      return {static_cast <u16> (sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0))};
+
+    if (exponent >= 0x1f)
+      return {static_cast <u16> (sign | 0x7c00)};
+
+    // subnormal half
+    if (exponent <= 0) {
+      if (exponent < -10)
+        return {static_cast <u16> (sign)};
+
+      mantissa |= 0x800000;
+
+      u32 shift = 14 - exponent;
+      u32 half = mantissa >> shift;
+
+      if ((mantissa >> (shift - 1)) & 1)
+        ++half;
+
+      return {static_cast <u16> (sign | half)};
+    }
+
+    // a carry out of the mantissa correctly bumps the exponent
+    u32 half = sign | (static_cast <u32> (exponent) << 10) | (mantissa >> 13);
+
+    if (mantissa & 0x1000)
+      ++half;
+
+    return {static_cast <u16> (half)};
+  }
+
+} // namespace gl
@@ -0,0 +1,55 @@
+#ifndef HEADER_VERTEX_FORMAT_H
+#define HEADER_VERTEX_FORMAT_H
+
+#include <glm/glm.hpp>
+
+#include "types.hpp"
+#include "vertex_buffer_layout.hpp"
+#include "mesh/bounds.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // Memory layout of a (position, color) vertex.
+  //
+  //   full     3 x GL_FLOAT position, 3 x GL_FLOAT color               24 bytes
+  //   snorm16  4 x normalised GL_SHORT position, 4 x GL_UNSIGNED_BYTE  12 bytes
+  //   half     4 x GL_HALF_FLOAT position, 4 x GL_UNSIGNED_BYTE        12 bytes
+  //
+  // The quantized formats store positions relative to the mesh bounding box,
+  // mapped to [-1, 1] on every axis (the fourth component is padding), and
+  // an RGBA color. get_dequantize_matrix maps them back into object space.
+  enum class vertex_format {
+    full,
+    snorm16,
+    half
+  };
+
+  vertex_buffer_layout get_vertex_layout (vertex_format);
+  glm::mat4 get_dequantize_matrix (vertex_format, const bounding_box&);
+
+  // Writes vertices of a format for a mesh with the given bounds
+  class vertex_encoder {
+    private:
+      vertex_format m_format;
+      u32 m_stride;
+      glm::vec3 m_center;
+      glm::vec3 m_inverse_extent;
+
+    public:
+      vertex_encoder (vertex_format, const bounding_box&);
+
+      u32 get_stride () const;
+
+      // Writes get_stride() bytes
+      void encode (const glm::vec3&, const glm::vec3&, byte*) const;
+  };
+
+  i16 to_snorm16 (f32);
+  byte to_unorm8 (f32);
+  f16 to_f16 (f32);
+
+} // namespace gl
+
+#endif // HEADER_VERTEX_FORMAT_H
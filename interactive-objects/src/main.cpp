@@ -1,15 +1,39 @@
+#include <charconv>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <system_error>
 
 #include "types.hpp"
 #include "application.hpp"
 #include "object.hpp"
 
-int main () {
+// interactive-objects [--headless [frames = 240] [output directory]]
+int main (int argc, char **argv) {
+  bool headless = argc > 1 and std::string(argv[1]) == "--headless";
+  gl::types::u32 frames = 240;
+  std::string output_directory = argc > 3 ? argv[3] : "";
+
+  if (argc > 2) {
+    const char *end = argv[2] + std::strlen(argv[2]);
+    auto [last, error] = std::from_chars(argv[2], end, frames);
+
+    if (error != std::errc() or last != end or frames == 0) {
+      std::cerr << "Usage: " << argv[0] << " [--headless [frames = 240] [output directory]]" << std::endl;
+      std::cerr << "The frame count has to be a positive number, not \"" << argv[2] << "\"" << std::endl;
+      return 1;
+    }
+  }
+
   {
-    gl::application* application = new gl::application(800, 600, 1000, "Interactive Objects");
+    gl::application* application = new gl::application(800, 600, 1000, "Interactive Objects", headless);
     
     application->initialise_demo();
-    application->run();
+
+    if (headless)
+      application->run_headless(frames, output_directory);
+    else
+      application->run();
 
     delete application;
   }
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -5,28 +7,49 @@
 #include <iostream>
 namespace gl {
 
-  object::object (const std::string &name)
+  object::object (const std::string &name, vertex_format format)
+    : m_name (name),
+      m_vertices (),
+      m_indices (),
+      m_blend (1.0f),
+      m_palette {0, 0},
+      m_transforms (&transform_storage::detached()),
+      m_transform (m_transforms->add()),
+      m_mesh (std::make_shared <gpu_mesh> (format)),
+      m_lod_index (0),
+      m_collides (true),
+      m_should_render (true)
+  {
+
+  }
+
+  object::object (const std::string &name, std::shared_ptr <gpu_mesh> mesh)
     : m_name (name),
       m_vertices (),
       m_indices (),
-      m_velocity (0.0f),
-      m_rotation_angles (0.0f, 0.0f, 0.0f),
       m_blend (1.0f),
-      m_translate(glm::mat4(1.0f)),
-      m_rotate(glm::mat4(1.0f)),
-      m_scale(glm::mat4(1.0f)),
-      m_vertex_array (),
-      m_vertex_buffer_layout (),
-      m_index_buffer (nullptr),
-      m_vertex_buffer (nullptr),
+      m_palette {0, 0},
+      m_transforms (&transform_storage::detached()),
+      m_transform (m_transforms->add()),
+      m_mesh (std::move(mesh)),
+      m_lod_index (0),
+      m_collides (true),
       m_should_render (true)
   {
-    m_vertex_buffer_layout.push <f32> (3); // vertex
-    m_vertex_buffer_layout.push <f32> (3); // color
+
   }
 
   object::~object () {
+    m_transforms->remove(m_transform);
+  }
 
+  object& object::move_to (transform_storage &transforms) {
+    u32 transform = transforms.add(*m_transforms, m_transform);
+    m_transforms->remove(m_transform);
+
+    m_transforms = &transforms;
+    m_transform = transform;
+    return *this;
   }
 
   object& object::add_vertex (const glm::vec3 &vertex, const glm::vec3 &color) {
@@ -43,43 +66,60 @@ namespace gl {
   object& object::clear () {
     m_vertices.clear();
     m_indices.clear();
-    m_translate = glm::mat4(1.0f);
-    m_rotate = glm::mat4(1.0f);
-    m_scale = glm::mat4(1.0f);
-    m_index_buffer.reset(nullptr);
-    m_vertex_buffer.reset(nullptr);
+    m_transforms->set_position(m_transform, glm::vec3(0.0f));
+    m_transforms->set_orientation(m_transform, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+    m_transforms->set_scale(m_transform, glm::vec3(1.0f));
+    // Other objects may still be drawing the old mesh
+    m_mesh = std::make_shared <gpu_mesh> (m_mesh->get_vertex_format());
+    m_lod_index = 0;
     return *this;
   }
 
+  // Positions are every other vector, colors the rest, see add_vertex
   object& object::load () {
-    m_index_buffer.reset(new index_buffer(m_indices.data(), m_indices.size()));
-    m_vertex_buffer.reset(new vertex_buffer(m_vertices.data(), 3 * sizeof(f32) * m_vertices.size()));
-    m_vertex_array.add_buffer(*m_vertex_buffer, m_vertex_buffer_layout);
+    std::vector <glm::vec3> positions;
+    positions.reserve(m_vertices.size() / 2);
+
+    for (u32 i = 0; i < m_vertices.size(); i += 2)
+      positions.push_back(m_vertices[i]);
+
+    bounding_box bounds = compute_bounds(positions);
+
+    m_mesh->set_bounds(bounds);
+    m_mesh->set_bounding_sphere(compute_bounding_sphere(positions, bounds));
+
+    return load(m_vertices.data(), 3 * sizeof(f32) * m_vertices.size(), m_indices.data(), m_indices.size());
+  }
+
+  object& object::load (const void *vertices, u32 size, const u32 *indices, u32 count) {
+    m_mesh->load(vertices, size, indices, count);
+    m_lod_index = 0;
     return *this;
   }
 
   object& object::translate (const glm::vec3& t) {
-    m_translate = glm::translate(m_translate, t);
+    m_transforms->set_position(m_transform, m_transforms->get_position(m_transform) + t);
     return *this;
   }
 
   object& object::rotate (f32 angle, const glm::vec3& r) {
-    m_rotate = glm::rotate(m_rotate, glm::radians(angle), r);
+    glm::quat rotation = glm::angleAxis(glm::radians(angle), glm::normalize(r));
+    m_transforms->set_orientation(m_transform, m_transforms->get_orientation(m_transform) * rotation);
     return *this;
   }
 
   object& object::scale (const glm::vec3& s) {
-    m_scale = glm::scale(m_scale, s);
+    m_transforms->set_scale(m_transform, m_transforms->get_scale(m_transform) * s);
     return *this;
   }
 
   object& object::set_velocity (const glm::vec3& v) {
-    m_velocity = v;
+    m_transforms->set_velocity(m_transform, v);
     return *this;
   }
 
   object& object::set_rotation_angles (const glm::vec3& v) {
-    m_rotation_angles = v;
+    m_transforms->set_angular_velocity(m_transform, v);
     return *this;
   }
 
@@ -88,39 +128,141 @@ namespace gl {
     return *this;
   }
 
+  object& object::set_collision (bool collides) {
+    m_collides = collides;
+    return *this;
+  }
+
   object& object::set_blend (f32 blend) {
     m_blend = blend;
     return *this;
   }
 
-  const glm::vec3& object::get_velocity () const {
-    return m_velocity;
+  object& object::set_palette (const color_palette &palette) {
+    m_palette = palette;
+    return *this;
+  }
+
+  // Picks the coarsest level whose error, scaled by the projected radius of
+  // the bounding sphere (in pixels), stays within the threshold (in pixels)
+  object& object::select_lod (f32 projected_radius, f32 threshold) {
+    const auto &lods = m_mesh->get_lods();
+    m_lod_index = 0;
+
+    while (m_lod_index + 1 < lods.size() and lods[m_lod_index + 1].m_error * projected_radius <= threshold)
+      ++m_lod_index;
+
+    return *this;
+  }
+
+  glm::vec3 object::get_velocity () const {
+    return m_transforms->get_velocity(m_transform);
   }
 
-  const glm::vec3& object::get_rotation_angles () const {
-    return m_rotation_angles;
+  glm::vec3 object::get_rotation_angles () const {
+    return m_transforms->get_angular_velocity(m_transform);
   }
 
-  const glm::mat4& object::get_translate () const {
-    return m_translate;
+  glm::vec3 object::get_position () const {
+    return m_transforms->get_position(m_transform);
   }
 
-  const glm::mat4& object::get_rotate () const {
-    return m_rotate;
+  glm::quat object::get_orientation () const {
+    return m_transforms->get_orientation(m_transform);
   }
 
-  const glm::mat4& object::get_scale () const {
-    return m_scale;
+  glm::vec3 object::get_scale () const {
+    return m_transforms->get_scale(m_transform);
+  }
+
+  const glm::mat4& object::get_transform () const {
+    return m_transforms->get_matrix(m_transform);
+  }
+
+  u32 object::get_transform_index () const {
+    return m_transform;
   }
 
   glm::mat4 object::get_model () const {
-    return m_translate * m_rotate * m_scale;
+    return get_transform() * m_mesh->get_dequantize();
   }
 
   f32 object::get_blend () const {
     return m_blend;
   }
 
+  const color_palette& object::get_palette () const {
+    return m_palette;
+  }
+
+  const bounding_box& object::get_bounds () const {
+    return m_mesh->get_bounds();
+  }
+
+  // World space sphere around the bounds as (center, radius)
+  glm::vec4 object::get_bounding_sphere () const {
+    const glm::mat4 &transform = get_transform();
+    const bounding_box &bounds = m_mesh->get_bounds();
+    glm::vec3 center = glm::vec3(transform * glm::vec4(bounds.get_center(), 1.0f));
+
+    f32 scale = std::max({
+      glm::length(glm::vec3(transform[0])),
+      glm::length(glm::vec3(transform[1])),
+      glm::length(glm::vec3(transform[2]))
+    });
+
+    return glm::vec4(center, glm::length(bounds.get_extent()) * scale);
+  }
+
+  // World space sphere around the mesh's own, see compute_bounding_sphere
+  glm::vec4 object::get_tight_bounding_sphere () const {
+    const glm::mat4 &transform = get_transform();
+    const glm::vec4 &sphere = m_mesh->get_bounding_sphere();
+    glm::vec3 center = glm::vec3(transform * glm::vec4(glm::vec3(sphere), 1.0f));
+
+    f32 scale = std::max({
+      glm::length(glm::vec3(transform[0])),
+      glm::length(glm::vec3(transform[1])),
+      glm::length(glm::vec3(transform[2]))
+    });
+
+    return glm::vec4(center, sphere.w * scale);
+  }
+
+  const std::vector <mesh_lod>& object::get_lods () const {
+    return m_mesh->get_lods();
+  }
+
+  const mesh_lod& object::get_lod () const {
+    return m_mesh->get_lods()[m_lod_index];
+  }
+
+  u32 object::get_lod_index () const {
+    return m_lod_index;
+  }
+
+  vertex_format object::get_vertex_format () const {
+    return m_mesh->get_vertex_format();
+  }
+
+  const gpu_mesh& object::get_mesh () const {
+    return *m_mesh;
+  }
+
+  // Whether the mesh is uploaded yet, objects streamed in by the application
+  // are not drawable before that
+  bool object::is_resident () const {
+    return m_mesh->is_resident();
+  }
+
+  bool object::has_collision () const {
+    return m_collides;
+  }
+
+  u32 object::get_vertex_stride () const {
+    return m_mesh->get_vertex_stride();
+  }
+
   const std::vector <glm::vec3>& object::get_vertices () const {
     return m_vertices;
   }
@@ -134,11 +276,11 @@ namespace gl {
   }
 
   const vertex_array& object::get_vertex_array () const {
-    return m_vertex_array;
+    return m_mesh->get_vertex_array();
   }
 
   const index_buffer& object::get_index_buffer () const {
-    return *m_index_buffer;
+    return m_mesh->get_index_buffer();
   }
 
   const std::string& object::get_name () const {
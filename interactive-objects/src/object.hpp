@@ -5,6 +5,9 @@
 #include <memory>
 
 #include "vertex/vertex.hpp"
+#include "mesh/gpu_mesh.hpp"
+#include "shader/palette_buffer.hpp"
+#include "transform_storage.hpp"
 
 namespace gl {
 
@@ -14,31 +17,46 @@ namespace gl {
       std::vector <glm::vec3> m_vertices;
       std::vector <u32> m_indices;
 
-      glm::vec3 m_velocity;
-      glm::vec3 m_rotation_angles;
       f32 m_blend;
 
-      glm::mat4 m_translate;
-      glm::mat4 m_rotate;
-      glm::mat4 m_scale;
-      
-      vertex_array m_vertex_array;
-      vertex_buffer_layout m_vertex_buffer_layout;
-      std::unique_ptr <index_buffer> m_index_buffer;
-      std::unique_ptr <vertex_buffer> m_vertex_buffer;
+      // What the color indices of a shared mesh turn into for this object
+      color_palette m_palette;
+
+      // Position, orientation, scale and their velocities live in a slot of
+      // the storage of the scene the object is in, see scene::add_object
+      transform_storage *m_transforms;
+      u32 m_transform;
+
+      // Possibly shared with other objects, the level of detail drawn is
+      // chosen per object
+      std::shared_ptr <gpu_mesh> m_mesh;
+      u32 m_lod_index;
+
+      // Whether the scene gives it a collider once its mesh is resident
+      bool m_collides;
 
     public:
       bool m_should_render;
     
     public:
-      object (const std::string&);
+      // add_vertex and load () only work with vertex_format::full, other
+      // formats are loaded already encoded with load (const void*, ...)
+      object (const std::string&, vertex_format = vertex_format::full);
+      object (const std::string&, std::shared_ptr <gpu_mesh>);
       ~object ();
 
+      object (const object&) = delete;
+      object& operator = (const object&) = delete;
+
+      // Moves the transform into a slot of `transforms`
+      object& move_to (transform_storage&);
+
       object& add_vertex (const glm::vec3&, const glm::vec3&);
       object& add_index  (u32);
 
       object& clear ();
       object& load ();
+      object& load (const void*, u32, const u32*, u32);
 
       object& translate (const glm::vec3&);
       object& rotate (f32, const glm::vec3&);
@@ -47,17 +65,44 @@ namespace gl {
       object& set_velocity (const glm::vec3&);
       object& set_rotation_angles (const glm::vec3&);
       object& set_render (bool);
+      object& set_collision (bool);
       object& set_blend (f32);
+      object& set_palette (const color_palette&);
+      object& select_lod (f32, f32);
+
+      glm::vec3 get_velocity () const;
+      glm::vec3 get_rotation_angles () const;
+
+      glm::vec3 get_position () const;
+      glm::quat get_orientation () const;
+      glm::vec3 get_scale () const;
 
-      const glm::vec3& get_velocity () const;
-      const glm::vec3& get_rotation_angles () const;
+      // translate * rotate * scale, cached until the transform changes
+      const glm::mat4& get_transform () const;
 
-      const glm::mat4& get_translate () const;
-      const glm::mat4& get_rotate () const;
-      const glm::mat4& get_scale () const;
+      // Its slot in the transform storage of its scene
+      u32 get_transform_index () const;
 
+      // The transform applied to the vertices as stored, i.e. after the
+      // mesh's dequantization
       glm::mat4 get_model () const;
       f32 get_blend () const;
+      const color_palette& get_palette () const;
+      const bounding_box& get_bounds () const;
+      glm::vec4 get_bounding_sphere () const;
+
+      // Tighter than get_bounding_sphere for round meshes, what the frustum
+      // culls by
+      glm::vec4 get_tight_bounding_sphere () const;
+
+      const std::vector <mesh_lod>& get_lods () const;
+      const mesh_lod& get_lod () const;
+      u32 get_lod_index () const;
+      vertex_format get_vertex_format () const;
+      const gpu_mesh& get_mesh () const;
+      bool is_resident () const;
+      bool has_collision () const;
+      u32 get_vertex_stride () const;
       const std::vector <glm::vec3>& get_vertices () const;
       std::vector <glm::vec3>& get_vertices ();
       const std::vector <u32>& get_indices () const;
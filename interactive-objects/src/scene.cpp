@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "scene.hpp"
 #include <iostream>
 namespace gl {
@@ -20,7 +22,9 @@ namespace gl {
     : m_name (name),
       m_scene_properties (properties),
       m_object_count (0),
-      m_objects () {
+      m_transforms (),
+      m_objects (),
+      m_pending_colliders () {
 
   }
 
@@ -29,55 +33,65 @@ namespace gl {
   }
 
   void scene::add_object (std::unique_ptr <object> &&o) {
+    o->move_to(m_transforms);
+
+    if (o->has_collision())
+      m_pending_colliders.push_back(m_objects.size());
+
     m_objects.emplace_back(std::move(o));
     ++m_object_count;
   }
 
-  void scene::on_update (f32 deltatime) {
-    for (u32 i = 0; i < m_object_count; ++i) {
-      auto &object = *m_objects[i];
-      auto translation = glm::vec3(object.get_translate()[3]);
-      auto new_velocity = object.get_velocity();
-      auto &rotation_angles = object.get_rotation_angles();
-
-      if ((translation.x > m_scene_properties.m_right_bound) or
-          (translation.x < m_scene_properties.m_left_bound)) {
-        new_velocity.x = -new_velocity.x;
-        
-        if (translation.x > m_scene_properties.m_right_bound)
-          translation.x = m_scene_properties.m_right_bound;
-        else if (translation.x < m_scene_properties.m_left_bound)
-          translation.x = m_scene_properties.m_left_bound;
-      }
-      
-      if ((translation.y > m_scene_properties.m_up_bound) or
-          (translation.y < m_scene_properties.m_down_bound)) {
-        new_velocity.y = -new_velocity.y;
-
-        if (translation.y > m_scene_properties.m_up_bound)
-          translation.y = m_scene_properties.m_up_bound;
-        else if (translation.y < m_scene_properties.m_down_bound)
-          translation.y = m_scene_properties.m_down_bound;
-      }
-      
-      if ((translation.z > m_scene_properties.m_front_bound) or
-          (translation.z < m_scene_properties.m_back_bound)) {
-        new_velocity.z = -new_velocity.z;
-
-        if (translation.y > m_scene_properties.m_front_bound)
-          translation.z = m_scene_properties.m_front_bound;
-        else if (translation.y < m_scene_properties.m_back_bound)
-          translation.z = m_scene_properties.m_back_bound;
-      }
-      
-      object.set_velocity(new_velocity);
-      object.translate(new_velocity * deltatime);
-      object.rotate(rotation_angles.x, {1, 0, 0});
-      object.rotate(rotation_angles.y, {0, 1, 0});
-      object.rotate(rotation_angles.z, {0, 0, 1});
-    }
+  // Objects bounce off the walls of the scene: a velocity component flips
+  // while the object is past a wall on that axis
+  void scene::simulate (transform_storage &state, f32 delta_time, job_system &jobs) const {
+    glm::vec3 lower (m_scene_properties.m_left_bound, m_scene_properties.m_down_bound, m_scene_properties.m_back_bound);
+    glm::vec3 upper (m_scene_properties.m_right_bound, m_scene_properties.m_up_bound, m_scene_properties.m_front_bound);
+
+    u32 size = state.get_size();
+    u32 blocks = (size + transform_block - 1) / transform_block;
+
+    jobs.parallel_for(0, blocks, 1, [&] (u32 first, u32 last) {
+      state.integrate(first * transform_block, std::min(last * transform_block, size), delta_time, lower, upper);
+    });
+  }
+
+  void scene::update_transforms (job_system &jobs) {
+    u32 size = m_transforms.get_size();
+    u32 blocks = (size + transform_block - 1) / transform_block;
+
+    jobs.parallel_for(0, blocks, 1, [&] (u32 first, u32 last) {
+      m_transforms.update_matrices(first * transform_block, std::min(last * transform_block, size));
+    });
   }
   
+  std::vector <std::pair <u32, glm::vec4>> scene::update_colliders () {
+    std::vector <std::pair <u32, glm::vec4>> colliders;
+
+    std::erase_if(m_pending_colliders, [&] (u32 index) {
+      const object &o = *m_objects[index];
+
+      if (not o.is_resident())
+        return false;
+
+      // A mesh of a single point has no sphere and never collides
+      const glm::vec4 &sphere = o.get_mesh().get_bounding_sphere();
+
+      if (sphere.w > 0.0f) {
+        m_transforms.set_collider(o.get_transform_index(), sphere);
+        colliders.emplace_back(o.get_transform_index(), sphere);
+      }
+
+      return true;
+    });
+
+    return colliders;
+  }
+
+  transform_storage& scene::get_transforms () {
+    return m_transforms;
+  }
+
   const scene_properties& scene::get_properties () const {
     return m_scene_properties;  
   }
@@ -2,10 +2,14 @@
 #define HEADER_SCENE_HPP
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "types.hpp"
 #include "camera.hpp"
 #include "object.hpp"
+#include "transform_storage.hpp"
+#include "job/job_system.hpp"
 
 namespace gl {
 
@@ -25,18 +29,47 @@ namespace gl {
 
   class scene {
     private:
+      // Slots per job of simulate and update_transforms, a multiple of the
+      // SIMD width
+      static constexpr u32 transform_block = 4096;
+
       std::string m_name;
       scene_properties m_scene_properties;
       u32 m_object_count;
+
+      // The transforms of m_objects, which must outlive them
+      transform_storage m_transforms;
       std::vector <std::unique_ptr <object>> m_objects;
 
+      // Objects that collide but have no collider yet, their mesh was still
+      // streaming in. Indices into m_objects
+      std::vector <u32> m_pending_colliders;
+
     public:
       scene (const std::string&, const scene_properties&);
       ~scene ();
 
       void add_object (std::unique_ptr <object>&&);
 
-      void on_update (f32);
+      // Both run on every thread of the job system, in blocks of
+      // transform_block slots.
+      //
+      // Steps `state`, a copy of the transforms the simulation keeps on its
+      // own thread, by `delta_time`. The scene itself is only read
+      void simulate (transform_storage&, f32, job_system&) const;
+
+      // Rebuilds the cached transforms of the objects that changed, in one
+      // pass. Called before the objects are drawn
+      void update_transforms (job_system&);
+
+      // Gives the colliding objects whose mesh became resident since the
+      // last call the bounding sphere of their mesh as collider, and returns
+      // those (slot, collider) so a running simulation can be given them too
+      std::vector <std::pair <u32, glm::vec4>> update_colliders ();
+
+      // What the objects are drawn with. While a simulation runs on the scene
+      // it writes the positions and orientations here, see simulation
+      transform_storage& get_transforms ();
 
       const scene_properties& get_properties () const;
       const std::vector <std::unique_ptr <object>>& get_objects () const;
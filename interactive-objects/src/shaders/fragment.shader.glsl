@@ -1,16 +1,17 @@
 #version 330 core
+#extension GL_ARB_shader_stencil_export : enable
 
-in vec3 color;
-
-uniform bool u_use_vertex_color;
-uniform float u_blend;
-uniform vec4 u_color;
+in vec4 color;
+flat in int stencil_ref;
 
 out vec4 FragColor;
 
 void main () {
-  if (u_use_vertex_color)
-    FragColor = vec4(color.xyz, u_blend);
-  else
-    FragColor = u_color;
+  FragColor = color;
+
+#ifdef GL_ARB_shader_stencil_export
+  // Replaces the reference of glStencilFunc, so draws of different stencil
+  // values can share a multi draw
+  gl_FragStencilRefARB = stencil_ref;
+#endif
 }
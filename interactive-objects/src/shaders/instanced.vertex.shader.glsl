@@ -0,0 +1,46 @@
+#version 330 core
+
+layout (location = 0) in vec3 i_pos;
+layout (location = 1) in vec3 i_color;
+
+// Per instance, see instance_data
+layout (location = 2) in mat4 i_model;
+layout (location = 6) in vec4 i_draw_color;
+layout (location = 7) in vec4 i_parameters;
+
+out vec4 color;
+flat out int stencil_ref;
+
+// Written once per frame, see frame_uniforms
+layout (std140) uniform frame {
+  mat4 u_view;
+  mat4 u_projection;
+  mat4 u_view_projection;
+  vec4 u_camera_position;
+  vec2 u_viewport;
+  float u_time;
+  float u_delta_time;
+};
+
+// Palettes of the objects, see palette_buffer
+uniform samplerBuffer u_palettes;
+
+// The vertex color, or with a palette (offset, size) the entry the red
+// channel of the vertex color indexes
+vec3 vertex_color (vec2 palette) {
+  int size = int(palette.y);
+
+  if (size == 0)
+    return i_color;
+
+  int entry = int(i_color.r * 255.0 + 0.5) % size;
+  return texelFetch(u_palettes, int(palette.x) + entry).rgb;
+}
+
+void main () {
+  gl_Position = u_view_projection * i_model * vec4(i_pos.xyz, 1.0);
+  color = i_parameters.y > 0.5 ? vec4(vertex_color(i_parameters.zw), i_parameters.x) : i_draw_color;
+
+  // Instances are not picked
+  stencil_ref = 0;
+}
@@ -1,15 +1,61 @@
 #version 330 core
+#extension GL_ARB_shader_draw_parameters : enable
 
 layout (location = 0) in vec3 i_pos;
 layout (location = 1) in vec3 i_color;
 
-out vec3 color;
+out vec4 color;
+flat out int stencil_ref;
 
-uniform mat4 u_model;
-uniform mat4 u_view;
-uniform mat4 u_projection;
+// Written once per frame, see frame_uniforms
+layout (std140) uniform frame {
+  mat4 u_view;
+  mat4 u_projection;
+  mat4 u_view_projection;
+  vec4 u_camera_position;
+  vec2 u_viewport;
+  float u_time;
+  float u_delta_time;
+};
+
+// Per draw records of 7 texels, see draw_program
+uniform samplerBuffer u_draws;
+uniform int u_draw;
+
+// Palettes of the objects, see palette_buffer
+uniform samplerBuffer u_palettes;
+
+// The vertex color, or with a palette (offset, size) the entry the red
+// channel of the vertex color indexes
+vec3 vertex_color (vec2 palette) {
+  int size = int(palette.y);
+
+  if (size == 0)
+    return i_color;
+
+  int entry = int(i_color.r * 255.0 + 0.5) % size;
+  return texelFetch(u_palettes, int(palette.x) + entry).rgb;
+}
 
 void main () {
-  gl_Position = u_projection * u_view * u_model * vec4(i_pos.xyz, 1.0);
-  color = i_color;
+#ifdef GL_ARB_shader_draw_parameters
+  // 0 outside of multi draws
+  int record = 7 * (u_draw + gl_DrawIDARB);
+#else
+  int record = 7 * u_draw;
+#endif
+
+  mat4 model = mat4(
+    texelFetch(u_draws, record + 0),
+    texelFetch(u_draws, record + 1),
+    texelFetch(u_draws, record + 2),
+    texelFetch(u_draws, record + 3)
+  );
+
+  vec4 draw_color = texelFetch(u_draws, record + 4);
+  vec4 parameters = texelFetch(u_draws, record + 5);
+  stencil_ref = int(texelFetch(u_draws, record + 6).x);
+
+  gl_Position = u_view_projection * model * vec4(i_pos.xyz, 1.0);
+  color = parameters.y > 0.5 ? vec4(vertex_color(parameters.zw), parameters.x) : draw_color;
 }
@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <chrono>
+
+#include "simulation.hpp"
+
+namespace gl {
+
+  // Slots per job when saving and blending snapshots
+  static constexpr u32 snapshot_grain = 4096;
+
+  simulation::simulation (job_system &jobs, f32 tick_rate)
+    : m_job_system (jobs),
+      m_tick_length (1.0 / tick_rate),
+      m_scene (nullptr),
+      m_state (),
+      m_collisions (),
+      m_broad_phase (broad_phase_type::spatial_hash),
+      m_snapshots (),
+      m_origin (0.0),
+      m_thread (),
+      m_mutex (),
+      m_tick_needed (),
+      m_tick_saved (),
+      m_needed (0),
+      m_saved (0),
+      m_stopping (false),
+      m_commands (),
+      m_step_time (0.0f),
+      m_collision_statistics {0, 0, 0, 0.0f, 0.0f} {
+
+  }
+
+  simulation::~simulation () {
+    stop();
+  }
+
+  void simulation::start (scene &s, f64 time) {
+    stop();
+
+    m_scene = &s;
+    m_state.assign(s.get_transforms());
+
+    u32 size = m_state.get_size();
+
+    for (auto &snapshot: m_snapshots)
+      snapshot.resize(size);
+
+    // Tick 0 is the scene as it is, the thread starts on tick 1 right away
+    m_state.save(0, size, m_snapshots[0]);
+    m_snapshots[0].m_tick = 0;
+
+    m_origin = time;
+    m_needed = 0;
+    m_saved = 0;
+    m_stopping = false;
+
+    m_thread = std::thread(&simulation::run, this);
+  }
+
+  void simulation::stop () {
+    if (m_scene == nullptr)
+      return;
+
+    {
+      std::lock_guard lock (m_mutex);
+      m_stopping = true;
+    }
+
+    m_tick_needed.notify_all();
+    m_thread.join();
+
+    // Posted after the last tick, they still count
+    for (auto &command: m_commands)
+      command(m_state);
+
+    m_commands.clear();
+
+    // The thread ran ahead of the last frame by a tick at most, so objects
+    // move by no more than that
+    m_scene->get_transforms().assign(m_state);
+    m_scene = nullptr;
+  }
+
+  void simulation::post (scene &s, std::function <void (transform_storage&)> &&command) {
+    if (&s != m_scene) {
+      command(s.get_transforms());
+      return;
+    }
+
+    std::lock_guard lock (m_mutex);
+    m_commands.push_back(std::move(command));
+  }
+
+  f32 simulation::interpolate (f64 time) {
+    if (m_scene == nullptr)
+      return 0.0f;
+
+    // Drawn between tick `needed - 1` and tick `needed`
+    f64 ticks = std::max(0.0, (time - m_origin) / m_tick_length);
+    u64 needed = static_cast <u64> (ticks) + 1;
+
+    {
+      std::unique_lock lock (m_mutex);
+
+      if (needed > m_saved + max_catch_up) {
+        u64 skipped = needed - m_saved - max_catch_up;
+
+        m_origin += skipped * m_tick_length;
+        ticks -= skipped;
+        needed -= skipped;
+      }
+
+      // Frame times only go forward, but the clock may be coarser than a tick
+      needed = std::max(needed, m_needed);
+      m_needed = needed;
+      m_tick_needed.notify_one();
+
+      m_tick_saved.wait(lock, [&] { return m_saved >= needed; });
+    }
+
+    f32 alpha = std::clamp(static_cast <f32> (ticks - (needed - 1)), 0.0f, 1.0f);
+
+    const transform_snapshot &from = m_snapshots[(needed - 1) % snapshot_count];
+    const transform_snapshot &to = m_snapshots[needed % snapshot_count];
+    transform_storage &transforms = m_scene->get_transforms();
+    u32 size = std::min <u32> (transforms.get_size(), to.m_position_x.size());
+
+    m_job_system.parallel_for(0, size, snapshot_grain, [&] (u32 first, u32 last) {
+      transforms.interpolate(first, last, from, to, alpha);
+    });
+
+    return alpha;
+  }
+
+  void simulation::set_broad_phase (broad_phase_type type) {
+    m_broad_phase = type;
+  }
+
+  scene* simulation::get_scene () const {
+    return m_scene;
+  }
+
+  f32 simulation::get_tick_rate () const {
+    return static_cast <f32> (1.0 / m_tick_length);
+  }
+
+  f32 simulation::get_step_time () const {
+    return m_step_time.load();
+  }
+
+  broad_phase_type simulation::get_broad_phase () const {
+    return m_broad_phase.load();
+  }
+
+  collision_statistics simulation::get_collision_statistics () {
+    std::lock_guard lock (m_mutex);
+    return m_collision_statistics;
+  }
+
+  u64 simulation::get_tick () {
+    std::lock_guard lock (m_mutex);
+    return m_saved;
+  }
+
+  // Stays one tick ahead of the newest one the renderer asked for. That tick
+  // goes to the one snapshot the renderer is not reading
+  void simulation::run () {
+    std::unique_lock lock (m_mutex);
+
+    while (true) {
+      m_tick_needed.wait(lock, [&] { return m_stopping or m_saved < m_needed + 1; });
+
+      if (m_stopping)
+        return;
+
+      u64 tick = m_saved + 1;
+      auto commands = std::move(m_commands);
+      m_commands.clear();
+
+      lock.unlock();
+
+      for (auto &command: commands)
+        command(m_state);
+
+      step(tick);
+
+      lock.lock();
+      m_saved = tick;
+      m_collision_statistics = m_collisions.get_statistics();
+      m_tick_saved.notify_all();
+    }
+  }
+
+  void simulation::step (u64 tick) {
+    auto start = std::chrono::steady_clock::now();
+
+    m_scene->simulate(m_state, static_cast <f32> (m_tick_length), m_job_system);
+    m_collisions.resolve(m_state, m_broad_phase.load(), m_job_system);
+
+    transform_snapshot &snapshot = m_snapshots[tick % snapshot_count];
+
+    m_job_system.parallel_for(0, m_state.get_size(), snapshot_grain, [&] (u32 first, u32 last) {
+      m_state.save(first, last, snapshot);
+    });
+
+    snapshot.m_tick = tick;
+
+    auto stop = std::chrono::steady_clock::now();
+    m_step_time = std::chrono::duration <f32, std::milli> (stop - start).count();
+  }
+
+} // namespace gl
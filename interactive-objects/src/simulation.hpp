@@ -0,0 +1,115 @@
+#ifndef HEADER_SIMULATION_H
+#define HEADER_SIMULATION_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "types.hpp"
+#include "scene.hpp"
+#include "transform_storage.hpp"
+#include "job/job_system.hpp"
+#include "physics/collision_system.hpp"
+
+namespace gl {
+
+  using namespace gl::types;
+
+  // Steps the transforms of one scene at a fixed rate on a thread of its own,
+  // so the motion is the same at any frame rate and overlaps rendering.
+  //
+  // The thread works on a copy of the scene's transforms and saves every
+  // tick as a snapshot. Each frame the render thread asks for the time it
+  // draws, waits for the tick after it if need be, and blends the scene's
+  // transforms between that tick and the one before. Tick k is saved to
+  // snapshot k % 3, so while the renderer reads ticks n - 1 and n the
+  // thread is free to run one tick ahead, n + 1, and no further.
+  //
+  // Every tick moves the objects, then keeps those with a collider apart,
+  // see collision_system.
+  //
+  // Changes to the motion of objects go through post while it runs, the
+  // scene's own transforms only hold what is drawn
+  class simulation {
+    private:
+      static constexpr u32 snapshot_count = 3;
+
+      // A frame later than this many ticks (a hitch, a breakpoint) skips the
+      // ticks in between rather than running them all at once
+      static constexpr u64 max_catch_up = 8;
+
+      job_system &m_job_system;
+      f64 m_tick_length;
+
+      scene *m_scene;
+      transform_storage m_state;
+      collision_system m_collisions;
+      std::atomic <broad_phase_type> m_broad_phase;
+      transform_snapshot m_snapshots[snapshot_count];
+
+      // The time of tick 0 on the clock of interpolate
+      f64 m_origin;
+
+      std::thread m_thread;
+      std::mutex m_mutex;
+      std::condition_variable m_tick_needed;
+      std::condition_variable m_tick_saved;
+      u64 m_needed;
+      u64 m_saved;
+      bool m_stopping;
+      std::vector <std::function <void (transform_storage&)>> m_commands;
+
+      // Milliseconds the last tick took and what its collisions did, for the
+      // GUI. The statistics are guarded by m_mutex
+      std::atomic <f32> m_step_time;
+      collision_statistics m_collision_statistics;
+
+    public:
+      // Ticks per second
+      simulation (job_system&, f32 = 60.0f);
+
+      // Stops, see stop
+      ~simulation ();
+
+      simulation (const simulation&) = delete;
+      simulation& operator = (const simulation&) = delete;
+
+      // Stops simulating the current scene, if any, and starts on this one,
+      // with tick 0 at `time`
+      void start (scene&, f64);
+
+      // Joins the thread and writes everything it simulated back into the
+      // scene's transforms
+      void stop ();
+
+      // Runs the function on the state of the scene's transforms: between two
+      // ticks if it is the scene being simulated, right away otherwise
+      void post (scene&, std::function <void (transform_storage&)>&&);
+
+      // Blends the scene's transforms to where they are at `time`, on the
+      // same clock as start. Returns how far between the two ticks that is
+      f32 interpolate (f64);
+
+      // Takes effect from the next tick on
+      void set_broad_phase (broad_phase_type);
+
+      scene* get_scene () const;
+      f32 get_tick_rate () const;
+      f32 get_step_time () const;
+      broad_phase_type get_broad_phase () const;
+      collision_statistics get_collision_statistics ();
+
+      // The newest tick saved
+      u64 get_tick ();
+
+    private:
+      void run ();
+      void step (u64);
+  };
+
+} // namespace gl
+
+#endif // HEADER_SIMULATION_H
@@ -1,10 +1,12 @@
 #include "GL/freeglut.h"
 #include "glm/glm.hpp"
+#include "job/job_system.hpp"
 
 #include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <random>
+#include <vector>
 
 // global and state variables
 namespace globals {
@@ -109,26 +111,65 @@ void display () {
 }
 
 /* helper function to generate points required to render Sierpinski Pyramid using
-   randomised algorithm */
+   randomised algorithm, one chain of the chaos game per thread of the job system */
 void generate_points () {
   using namespace globals;
 
-  glm::vec3 p = vertices[0];
+  gl::job_system jobs;
+  int chain_count = jobs.get_thread_count();
 
-  points.reserve(total_points);
-  for (int i = 0; i < total_points; ++i) {
-    auto q = midway_point(p, vertices[int_distribution(rng)]);
-    points.push_back(q);
-    p = q;
-  }
+  // seeds are drawn up front, the shared generator is not thread safe
+  std::vector <unsigned int> seeds (chain_count);
+  for (auto &seed: seeds)
+    seed = rng();
+
+  points.resize(total_points);
+
+  auto chain_begin = [] (int chain, int chain_count) {
+    return points.begin() + static_cast <long> (total_points) * chain / chain_count;
+  };
 
-  std::sort(points.begin(), points.end(), [] (auto &l, auto &r) {
+  auto by_row = [] (auto &l, auto &r) {
     if (l.y < r.y)
       return true;
     if (l.y > r.y)
       return false;
     return l.x < r.x;
+  };
+
+  // every chain walks and sorts its own share of the points
+  jobs.parallel_for(0, chain_count, 1, [&] (unsigned int first, unsigned int last) {
+    for (int chain = first; chain < (int)last; ++chain) {
+      std::mt19937 chain_rng (seeds[chain]);
+      auto distribution = int_distribution;
+      glm::vec3 p = vertices[0];
+
+      auto end = chain_begin(chain + 1, chain_count);
+      for (auto point = chain_begin(chain, chain_count); point != end; ++point) {
+        *point = midway_point(p, vertices[distribution(chain_rng)]);
+        p = *point;
+      }
+
+      std::sort(chain_begin(chain, chain_count), end, by_row);
+    }
   });
+
+  // then neighbouring sorted runs are merged pairwise until one is left
+  for (int width = 1; width < chain_count; width *= 2) {
+    int pair_count = (chain_count + 2 * width - 1) / (2 * width);
+
+    jobs.parallel_for(0, pair_count, 1, [&] (unsigned int first, unsigned int last) {
+      for (int pair = first; pair < (int)last; ++pair) {
+        int begin = pair * 2 * width;
+        int middle = std::min(begin + width, chain_count);
+        int end = std::min(begin + 2 * width, chain_count);
+
+        std::inplace_merge(
+          chain_begin(begin, chain_count), chain_begin(middle, chain_count), chain_begin(end, chain_count), by_row
+        );
+      }
+    });
+  }
 }
 
 /* helper function to find midpoint of two points */